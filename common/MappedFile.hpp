@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ncommon
+{
+	// Whole file as read only memory, the system loads the pages when they are touched
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile() { close(); }
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool open(const char* filename);
+		void close();
+
+		bool is_open() const { return _is_open; }
+
+		// Empty file has no data
+		const char* data() const { return _data; }
+		size_t size() const { return _size; }
+
+	private:
+		const char* _data{};
+		size_t _size{};
+		bool _is_open{};
+
+#if defined(_WIN32)
+		HANDLE _file{ INVALID_HANDLE_VALUE };
+		HANDLE _mapping{};
+#endif
+	};
+
+
+#if defined(_WIN32)
+	inline bool MappedFile::open(const char* filename)
+	{
+		close();
+
+		_file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (_file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER file_size{};
+		if (!GetFileSizeEx(_file, &file_size))
+		{
+			close();
+			return false;
+		}
+		_size = static_cast<size_t>(file_size.QuadPart);
+		_is_open = true;
+
+		if (_size == 0)
+			return true;
+
+		_mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		_data = _mapping ? static_cast<const char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+		if (!_data)
+		{
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	inline void MappedFile::close()
+	{
+		if (_data)
+			UnmapViewOfFile(_data);
+		if (_mapping)
+			CloseHandle(_mapping);
+		if (_file != INVALID_HANDLE_VALUE)
+			CloseHandle(_file);
+
+		_file = INVALID_HANDLE_VALUE;
+		_mapping = nullptr;
+		_data = nullptr;
+		_size = 0;
+		_is_open = false;
+	}
+#else
+	inline bool MappedFile::open(const char* filename)
+	{
+		close();
+
+		int file = ::open(filename, O_RDONLY);
+		if (file < 0)
+			return false;
+
+		struct stat file_stat {};
+		if (fstat(file, &file_stat) != 0)
+		{
+			::close(file);
+			return false;
+		}
+		_size = static_cast<size_t>(file_stat.st_size);
+
+		// Mapping stays valid after the file is closed
+		if (_size)
+		{
+			void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, file, 0);
+			if (data == MAP_FAILED)
+			{
+				::close(file);
+				_size = 0;
+				return false;
+			}
+
+			// Pieces are read from the start to the end
+			madvise(data, _size, MADV_SEQUENTIAL);
+			_data = static_cast<const char*>(data);
+		}
+
+		::close(file);
+		_is_open = true;
+		return true;
+	}
+
+	inline void MappedFile::close()
+	{
+		if (_data)
+			munmap(const_cast<char*>(_data), _size);
+
+		_data = nullptr;
+		_size = 0;
+		_is_open = false;
+	}
+#endif
+}
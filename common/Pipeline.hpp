@@ -0,0 +1,293 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ncommon
+{
+	// Bounded queue without locks for many producers and consumers:
+	// every cell has a sequence number which tells whose turn it is (D. Vyukov)
+	template<typename T>
+	class BoundedQueue
+	{
+	public:
+		// Capacity is rounded up to a power of two
+		explicit BoundedQueue(size_t capacity);
+
+		BoundedQueue(const BoundedQueue&) = delete;
+		BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+		bool try_push(const T& value);
+		bool try_pop(T& value);
+
+		// Wait while the queue is full or empty
+		void push(const T& value);
+		T pop();
+
+	private:
+		struct cell
+		{
+			std::atomic<size_t> sequence;
+			T value;
+		};
+
+		std::unique_ptr<cell[]> _cells;
+		size_t _mask{};
+
+		alignas(64) std::atomic<size_t> _push_position{};
+		alignas(64) std::atomic<size_t> _pop_position{};
+	};
+
+
+	// Spins a little, then gives the core away, so idle stages do not burn it
+	inline void wait_backoff(size_t& spins)
+	{
+		if (++spins < 64)
+			std::this_thread::yield();
+		else
+			std::this_thread::sleep_for(std::chrono::microseconds(50));
+	}
+
+
+	// One piece of a stream, the pipeline owns a fixed set of them
+	struct pipeline_buffer
+	{
+		std::string input;
+		std::string output;
+
+		// Place in the stream, the writer gets the buffers in this order
+		uint64_t sequence{};
+
+		// Free value from the reader to the workers, e.g. position or chaining block of the piece
+		uint64_t context{};
+
+		// Set by the reader on the last piece
+		bool is_last{};
+	};
+
+
+	// Reader (calling thread) -> workers -> writer thread, connected by bounded queues of buffer indices.
+	// Disk reads, computation and writes overlap, memory use is bounded by the count of buffers.
+	class Pipeline
+	{
+	public:
+		Pipeline(size_t workers_count, size_t buffers_count);
+
+		// read fills buffer.input and returns false when there is no data left,
+		// transform makes buffer.output on a worker thread,
+		// write gets the buffers in the reading order and returns false on error, then the reading stops
+		bool run(const std::function<bool(pipeline_buffer&)>& read,
+			const std::function<void(pipeline_buffer&)>& transform,
+			const std::function<bool(pipeline_buffer&)>& write);
+
+	private:
+		// Marks the end of the work for a worker
+		static constexpr size_t _stop_index = ~size_t{};
+
+		size_t _workers_count;
+		std::vector<pipeline_buffer> _buffers;
+	};
+
+
+	template<typename T>
+	BoundedQueue<T>::BoundedQueue(size_t capacity)
+	{
+		size_t size{ 2 };
+		while (size < capacity)
+			size <<= 1;
+
+		_cells = std::make_unique<cell[]>(size);
+		_mask = size - 1;
+
+		for (size_t i = 0; i < size; ++i)
+			_cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	template<typename T>
+	bool BoundedQueue<T>::try_push(const T& value)
+	{
+		size_t position = _push_position.load(std::memory_order_relaxed);
+
+		while (true)
+		{
+			cell& target = _cells[position & _mask];
+			size_t sequence = target.sequence.load(std::memory_order_acquire);
+			intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+			// Cell is free for this position, try to take it
+			if (difference == 0)
+			{
+				if (_push_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					target.value = value;
+					target.sequence.store(position + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			// Cell still holds a value from the previous lap: the queue is full
+			else if (difference < 0)
+				return false;
+			else
+				position = _push_position.load(std::memory_order_relaxed);
+		}
+	}
+
+	template<typename T>
+	bool BoundedQueue<T>::try_pop(T& value)
+	{
+		size_t position = _pop_position.load(std::memory_order_relaxed);
+
+		while (true)
+		{
+			cell& target = _cells[position & _mask];
+			size_t sequence = target.sequence.load(std::memory_order_acquire);
+			intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+
+			// Cell has a value for this position, try to take it
+			if (difference == 0)
+			{
+				if (_pop_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					value = target.value;
+					target.sequence.store(position + _mask + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			// Nothing was pushed to this position yet: the queue is empty
+			else if (difference < 0)
+				return false;
+			else
+				position = _pop_position.load(std::memory_order_relaxed);
+		}
+	}
+
+	template<typename T>
+	void BoundedQueue<T>::push(const T& value)
+	{
+		for (size_t spins = 0; !try_push(value);)
+			wait_backoff(spins);
+	}
+
+	template<typename T>
+	T BoundedQueue<T>::pop()
+	{
+		T value{};
+		for (size_t spins = 0; !try_pop(value);)
+			wait_backoff(spins);
+		return value;
+	}
+
+
+	inline Pipeline::Pipeline(size_t workers_count, size_t buffers_count)
+		: _workers_count(workers_count ? workers_count : 1), _buffers(buffers_count ? buffers_count : 1)
+	{
+	}
+
+	inline bool Pipeline::run(const std::function<bool(pipeline_buffer&)>& read,
+		const std::function<void(pipeline_buffer&)>& transform,
+		const std::function<bool(pipeline_buffer&)>& write)
+	{
+		size_t buffers_count = _buffers.size();
+
+		// Free buffers go from the writer back to the reader
+		BoundedQueue<size_t> free_queue(buffers_count);
+		BoundedQueue<size_t> work_queue(buffers_count + _workers_count);
+		BoundedQueue<size_t> done_queue(buffers_count);
+
+		for (size_t i = 0; i < buffers_count; ++i)
+			free_queue.push(i);
+
+		// Count of the pieces is known only when the reader is done
+		std::atomic<uint64_t> pieces_count{ ~uint64_t{} };
+		std::atomic<bool> is_failed{};
+
+		std::vector<std::thread> workers;
+		for (size_t w = 0; w < _workers_count; ++w)
+		{
+			workers.emplace_back([this, &work_queue, &done_queue, &transform]()
+				{
+					for (size_t index = work_queue.pop(); index != _stop_index; index = work_queue.pop())
+					{
+						transform(_buffers[index]);
+						done_queue.push(index);
+					}
+				}
+			);
+		}
+
+		std::thread writer([this, buffers_count, &free_queue, &done_queue, &write, &pieces_count, &is_failed]()
+			{
+				// Buffers which came before their turn, at most one per buffer
+				std::vector<size_t> waiting(buffers_count, _stop_index);
+				uint64_t next_sequence{};
+
+				for (size_t spins = 0; next_sequence != pieces_count.load(std::memory_order_acquire);)
+				{
+					size_t index{};
+					if (!done_queue.try_pop(index))
+					{
+						wait_backoff(spins);
+						continue;
+					}
+					spins = 0;
+					waiting[_buffers[index].sequence % buffers_count] = index;
+
+					for (size_t slot = next_sequence % buffers_count; waiting[slot] != _stop_index; slot = next_sequence % buffers_count)
+					{
+						size_t ready_index = waiting[slot];
+						waiting[slot] = _stop_index;
+
+						if (!is_failed.load(std::memory_order_relaxed) and !write(_buffers[ready_index]))
+							is_failed.store(true, std::memory_order_relaxed);
+
+						free_queue.push(ready_index);
+						++next_sequence;
+					}
+				}
+			}
+		);
+
+		uint64_t sequence{};
+		while (!is_failed.load(std::memory_order_relaxed))
+		{
+			size_t index = free_queue.pop();
+			pipeline_buffer& buffer = _buffers[index];
+
+			buffer.sequence = sequence;
+			buffer.context = 0;
+			buffer.is_last = false;
+
+			if (!read(buffer))
+			{
+				free_queue.push(index);
+				break;
+			}
+
+			// Buffer belongs to the workers after the push
+			bool is_last = buffer.is_last;
+			work_queue.push(index);
+			++sequence;
+
+			if (is_last)
+				break;
+		}
+
+		pieces_count.store(sequence, std::memory_order_release);
+		for (size_t w = 0; w < _workers_count; ++w)
+			work_queue.push(_stop_index);
+
+		for (auto& worker : workers)
+			worker.join();
+		writer.join();
+
+		return !is_failed.load();
+	}
+}
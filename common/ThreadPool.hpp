@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ncommon
+{
+	// Fixed set of worker threads for data parallel loops
+	class ThreadPool
+	{
+	public:
+		// 0 threads means one thread per hardware thread
+		explicit ThreadPool(size_t threads_count = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		// Calling thread takes part in the work too
+		size_t size() const { return _workers.size() + 1; }
+
+		// Calls task(i) for every i in [0, tasks_count) and returns when all of them are done
+		void parallel_for(size_t tasks_count, const std::function<void(size_t)>& task);
+
+	private:
+		void _worker_loop();
+		void _run_tasks();
+
+	private:
+		std::vector<std::thread> _workers;
+
+		std::mutex _call_mutex;
+		std::mutex _mutex;
+		std::condition_variable _start_condition;
+		std::condition_variable _done_condition;
+
+		const std::function<void(size_t)>* _task{};
+		size_t _tasks_count{};
+		std::atomic<size_t> _next_task{};
+
+		size_t _active_workers{};
+		uint64_t _generation{};
+		bool _stop{};
+	};
+
+
+	inline ThreadPool::ThreadPool(size_t threads_count)
+	{
+		if (threads_count == 0)
+			threads_count = std::thread::hardware_concurrency();
+
+		for (size_t i = 1; i < threads_count; ++i)
+			_workers.emplace_back(&ThreadPool::_worker_loop, this);
+	}
+
+	inline ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_stop = true;
+		}
+		_start_condition.notify_all();
+
+		for (auto& worker : _workers)
+			worker.join();
+	}
+
+	inline void ThreadPool::parallel_for(size_t tasks_count, const std::function<void(size_t)>& task)
+	{
+		if (_workers.empty() or tasks_count < 2)
+		{
+			for (size_t i = 0; i < tasks_count; ++i)
+				task(i);
+			return;
+		}
+
+		// One loop at a time, other callers wait for their turn
+		std::lock_guard<std::mutex> call_lock(_call_mutex);
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_task = &task;
+			_tasks_count = tasks_count;
+			_next_task = 0;
+			_active_workers = _workers.size();
+			++_generation;
+		}
+		_start_condition.notify_all();
+
+		_run_tasks();
+
+		std::unique_lock<std::mutex> lock(_mutex);
+		_done_condition.wait(lock, [this] { return _active_workers == 0; });
+		_task = nullptr;
+	}
+
+	inline void ThreadPool::_worker_loop()
+	{
+		uint64_t generation{};
+
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				_start_condition.wait(lock, [this, generation] { return _stop or _generation != generation; });
+
+				if (_stop)
+					return;
+				generation = _generation;
+			}
+
+			_run_tasks();
+
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (--_active_workers == 0)
+				_done_condition.notify_one();
+		}
+	}
+
+	inline void ThreadPool::_run_tasks()
+	{
+		// Tasks are taken one by one, so faster threads do more of them
+		for (size_t i = _next_task.fetch_add(1); i < _tasks_count; i = _next_task.fetch_add(1))
+			(*_task)(i);
+	}
+}
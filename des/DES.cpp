@@ -3,17 +3,20 @@
 #include <sstream>
 
 #include <algorithm>
+#include <filesystem>
 #include <random>
-
-#include <bitset>
+#include <thread>
 
 #include "DES.hpp"
+#include "DESBitslice.hpp"
+#include "DESCMAC.hpp"
+#include "DESKeySchedule.hpp"
 
 bool ndes::DES::open_data_file(const char* const filepath)
 {
 	std::ifstream fin;
 
-	fin.open(filepath);
+	fin.open(filepath, std::ios::binary);
 	if (!fin.is_open())
 	{
 		std::cout << "Cannot open data file [" << filepath << "]!\n" << std::endl;
@@ -32,6 +35,7 @@ bool ndes::DES::open_data_file(const char* const filepath)
 
 void ndes::DES::set_keyword(const std::string& keyword)
 {
+	_is_triple = false;
 	_keyword = keyword;
 
 	if (keyword.size() == DES_KEY_SIZE)
@@ -39,7 +43,40 @@ void ndes::DES::set_keyword(const std::string& keyword)
 	else if (keyword.size() > DES_KEY_SIZE)
 		_keyword = _keyword.substr(0, DES_KEY_SIZE);
 	else
-		_keyword += create_random_key().substr(0, DES_KEY_SIZE - _keyword.size());
+	{
+		// Random key is made first, since create_random_key() replaces the keyword
+		std::string random_key = create_random_key();
+		_keyword = keyword + random_key.substr(0, DES_KEY_SIZE - keyword.size());
+	}
+}
+
+void ndes::DES::set_triple_keyword(const std::string& keyword)
+{
+	// Up to 16 symbols is a two keys EDE, longer keywords are three keys EDE
+	size_t keyword_size = (keyword.size() <= DES_TRIPLE_KEY2_SIZE) ? DES_TRIPLE_KEY2_SIZE : DES_TRIPLE_KEY3_SIZE;
+	std::string random_key = create_random_key();
+
+	_keyword = keyword.substr(0, keyword_size);
+	while (_keyword.size() < keyword_size)
+		_keyword += random_key.substr(0, keyword_size - _keyword.size());
+
+	_is_triple = true;
+}
+
+ndes::des_key_schedule_ptr ndes::DES::get_key_schedule()
+{
+	_create_sub_keys();
+	return _key_schedule;
+}
+
+void ndes::DES::set_key_schedule(des_key_schedule_ptr key_schedule)
+{
+	if (!key_schedule)
+		return;
+
+	_keyword = key_schedule->key();
+	_is_triple = key_schedule->is_triple();
+	_key_schedule = std::move(key_schedule);
 }
 
 std::string ndes::DES::create_random_key()
@@ -57,43 +94,523 @@ std::string ndes::DES::create_random_key()
 	for (int16_t i = 0; i < DES_KEY_SIZE; ++i) 
 		random_key += alphanum[dist() % (sizeof(alphanum) - 1)];
 
+	_is_triple = false;
 	_keyword = random_key;
 	return random_key;
 }
 
 void ndes::DES::encode()
 {
-	_padding_counter = 0;
-	_encrypt(DES_ENCODE);
-	_write_result(DES_ENCODE);
+	_init_message(true);
+	if (_encrypt(DES_ENCODE))
+		_write_result(DES_ENCODE);
 	_reset_data();
 }
 
 void ndes::DES::decode()
 {
-	_encrypt(DES_DECODE);
-	_write_result(DES_DECODE);
+	if (_encrypt(DES_DECODE))
+		_write_result(DES_DECODE);
 	_reset_data();
 }
 
-std::string ndes::DES::_ascii_to_bin(const std::string& str)
+bool ndes::DES::encrypt(std::span<const uint8_t> input, std::span<uint8_t> output)
 {
-	std::string bin;
-	bin.reserve(str.size() * 8);
+	return _encrypt_span(input, output, DES_ENCODE);
+}
 
-	for (auto chr : str)
-		bin += std::bitset<8>(chr).to_string();
-	return bin;
+bool ndes::DES::decrypt(std::span<const uint8_t> input, std::span<uint8_t> output)
+{
+	return _encrypt_span(input, output, DES_DECODE);
 }
 
-std::string ndes::DES::_bin_to_ascii(const std::string& bin)
+bool ndes::DES::encrypt_and_mac(std::span<const uint8_t> input, std::span<uint8_t> output, uint64_t& tag)
 {
-	std::string str;
-	str.reserve(bin.size() / 8);
+	DESCMAC mac(_get_mac_key_schedule());
+
+	if (!_encrypt_span(input, output, DES_ENCODE, &mac))
+		return false;
 
-	for (int32_t i = 0; i < bin.size(); i += 8)
-		str += static_cast<char>(std::bitset<8>(bin.substr(i, 8)).to_ulong());
-	return str;
+	tag = mac.finish();
+	return true;
+}
+
+bool ndes::DES::decrypt_and_verify(std::span<const uint8_t> input, std::span<uint8_t> output, uint64_t tag)
+{
+	DESCMAC mac(_get_mac_key_schedule());
+	mac.update(reinterpret_cast<const char*>(input.data()), input.size());
+
+	// Nothing is decrypted from the data which was changed
+	if (mac.finish() != tag)
+		return false;
+
+	return _encrypt_span(input, output, DES_DECODE);
+}
+
+bool ndes::DES::encrypt_batch(std::span<const des_record> records)
+{
+	return _encrypt_batch(records, DES_ENCODE);
+}
+
+bool ndes::DES::decrypt_batch(std::span<const des_record> records)
+{
+	return _encrypt_batch(records, DES_DECODE);
+}
+
+bool ndes::DES::encode_file(const char* const input_filepath, const char* const output_filepath)
+{
+	std::ifstream fin(input_filepath, std::ios::binary);
+	if (!fin.is_open())
+	{
+		std::cout << "Cannot open file [" << input_filepath << "] to encrypt!\n" << std::endl;
+		return false;
+	}
+
+	std::ofstream fout(output_filepath, std::ios::binary);
+	if (!fout.is_open())
+	{
+		std::cout << "Cannot open file [" << output_filepath << "] to encrypt!\n" << std::endl;
+		return false;
+	}
+
+	// Output which could not be finished is not left behind
+	auto remove_output = [&fout, output_filepath]()
+		{
+			std::error_code error;
+			fout.close();
+			std::filesystem::remove(output_filepath, error);
+			return false;
+		};
+
+	if (_keyword.empty())
+		create_random_key();
+
+	std::cout << "Start encrypting file [" << input_filepath << "] using key [" << _keyword << "].\n" << std::endl;
+
+	_init_message(true);
+	_create_sub_keys();
+
+	// Padding size is known only at the end, so the header is written again then
+	std::string chunk_header = _create_header();
+	fout << chunk_header;
+
+	// Tag is taken from every piece on its way to the file
+	DESCMAC mac(_get_mac_key_schedule());
+
+	// Modes with a chain from block to block have one worker, which carries the chain between the pieces.
+	// Chunks of indexed data do not depend on each other in any mode
+	bool is_parallel = _is_data_indexed or _is_parallel_mode(DES_ENCODE);
+	size_t workers_count = is_parallel ? _get_threads_count() : 1;
+	ncommon::Pipeline pipeline(workers_count, 2 * workers_count + 2);
+
+	std::string pending_data;
+	size_t input_size{};
+	uint64_t block_position{};
+	uint64_t chaining_block{ _data_iv };
+
+	std::string index;
+	uint64_t chunks_count{};
+	uint64_t data_offset{ DES_HEADER_SIZE };
+
+	// Only whole blocks are encrypted, the rest waits for the next piece
+	auto read_piece = [&](ncommon::pipeline_buffer& buffer)
+		{
+			if (!fin)
+				return false;
+
+			buffer.input.assign(pending_data);
+			buffer.input.resize(pending_data.size() + DES_STREAM_CHUNK_SIZE);
+			fin.read(buffer.input.data() + pending_data.size(), DES_STREAM_CHUNK_SIZE);
+			buffer.input.resize(pending_data.size() + static_cast<size_t>(fin.gcount()));
+
+			// Work ONLY with ASCII
+			_remove_non_ascii(buffer.input);
+			input_size += buffer.input.size() - pending_data.size();
+
+			// Padding goes only to the end of the last piece
+			buffer.is_last = !fin or fin.peek() == std::char_traits<char>::eof();
+			if (buffer.is_last)
+				_add_padding(buffer.input);
+
+			// Indexed data goes in whole chunks, so no chunk is split between the pieces
+			size_t piece_unit = (_is_data_indexed and !buffer.is_last) ? DES_INDEX_CHUNK_SIZE : 8;
+			size_t whole_size = buffer.input.size() - buffer.input.size() % piece_unit;
+			pending_data.assign(buffer.input, whole_size);
+			buffer.input.resize(whole_size);
+
+			// Counter of the first block of the piece for CTR mode, the block itself for indexed data
+			buffer.context = _is_data_indexed ? block_position : _data_iv + block_position;
+			block_position += whole_size / 8;
+			return true;
+		};
+
+	auto encrypt_piece = [&](ncommon::pipeline_buffer& buffer)
+		{
+			buffer.output.resize(buffer.input.size());
+
+			if (_is_data_indexed)
+			{
+				_encrypt_index_chunks(buffer.input.data(), buffer.output.data(), buffer.input.size(), DES_INDEX_CHUNK_SIZE, DES_ENCODE, buffer.context);
+				return;
+			}
+
+			uint64_t last_chaining_block = _encrypt_chunks(buffer.input.data(), buffer.output.data(), buffer.input.size() / 8, DES_ENCODE, is_parallel ? buffer.context : chaining_block);
+
+			if (!is_parallel)
+				chaining_block = last_chaining_block;
+		};
+
+	auto write_piece = [&](ncommon::pipeline_buffer& buffer)
+		{
+			if (_is_data_authenticated and !_is_data_indexed)
+				mac.update(buffer.output.data(), buffer.output.size());
+
+			// Offset and tag of every chunk go to the index
+			if (_is_data_indexed)
+			{
+				for (size_t offset = 0; offset < buffer.output.size(); offset += DES_INDEX_CHUNK_SIZE, ++chunks_count)
+				{
+					size_t chunk_size = std::min(DES_INDEX_CHUNK_SIZE, buffer.output.size() - offset);
+					bool is_last = buffer.is_last and offset + chunk_size == buffer.output.size();
+
+					char entry[DES_INDEX_ENTRY_SIZE];
+					_block_to_bytes(data_offset + offset, entry);
+					_block_to_bytes(_is_data_authenticated ? _get_index_chunk_tag(buffer.output.data() + offset, chunk_size, chunks_count, is_last, chunk_header) : 0, entry + 8);
+					index.append(entry, DES_INDEX_ENTRY_SIZE);
+				}
+				data_offset += buffer.output.size();
+			}
+
+			fout.write(buffer.output.data(), buffer.output.size());
+			return static_cast<bool>(fout);
+		};
+
+	if (!pipeline.run(read_piece, encrypt_piece, write_piece))
+	{
+		std::cout << "Cannot write file [" << output_filepath << "]!\n" << std::endl;
+		return remove_output();
+	}
+
+	// Index without chunks has no tag, so nothing would prove that the data was not cut off
+	if (_is_data_indexed and _is_data_authenticated and !chunks_count)
+	{
+		std::cout << "Cannot encode data, because, authenticated indexed data must have at least one block!\n" << std::endl;
+		return remove_output();
+	}
+
+	std::string header = _create_header();
+	fout.seekp(0);
+	fout << header;
+
+	if (_is_data_indexed)
+	{
+		char trailer[DES_INDEX_TRAILER_SIZE];
+		_block_to_bytes(DES_INDEX_CHUNK_SIZE, trailer);
+		_block_to_bytes(chunks_count, trailer + 8);
+
+		fout.seekp(0, std::ios::end);
+		fout.write(index.data(), index.size());
+		fout.write(trailer, DES_INDEX_TRAILER_SIZE);
+	}
+	else if (_is_data_authenticated)
+	{
+		mac.update(header.data(), header.size());
+
+		char tag[DES_MAC_SIZE];
+		_block_to_bytes(mac.finish(), tag);
+
+		fout.seekp(0, std::ios::end);
+		fout.write(tag, DES_MAC_SIZE);
+	}
+
+	fout.close();
+	if (!fout)
+	{
+		std::cout << "Cannot write file [" << output_filepath << "]!\n" << std::endl;
+		return remove_output();
+	}
+
+	_reset_data();
+	std::cout << "End encrypting using key [" << _keyword << "].\nInput size is [" << input_size << "] byte(-es)." << std::endl;
+	std::cout << "Output file is [" << output_filepath << "]\n" << std::endl;
+	return true;
+}
+
+bool ndes::DES::decode_file(const char* const input_filepath, const char* const output_filepath)
+{
+	std::ifstream fin(input_filepath, std::ios::binary);
+
+	if (!fin.is_open())
+	{
+		std::cout << "Cannot open file [" << input_filepath << "] to decrypt!\n" << std::endl;
+		return false;
+	}
+
+	if (_keyword.empty())
+		create_random_key();
+
+	std::cout << "Start decrypting file [" << input_filepath << "] using key [" << _keyword << "].\n" << std::endl;
+
+	std::string header(DES_HEADER_SIZE, '\0');
+	fin.read(header.data(), header.size());
+	header.resize(static_cast<size_t>(fin.gcount()));
+
+	if (!_parse_header(header))
+		return false;
+
+	_create_sub_keys();
+
+	// Encoded data is between the header and the tag or the index
+	fin.seekg(0, std::ios::end);
+	uint64_t data_size = static_cast<uint64_t>(fin.tellg()) - DES_HEADER_SIZE;
+	des_index index{};
+
+	if (_is_data_indexed)
+	{
+		if (!_read_index(fin, index))
+		{
+			std::cout << "Cannot decode data, because, index of the data is invalid!\n" << std::endl;
+			return false;
+		}
+		data_size = index.data_size;
+
+		// All the chunks are checked before the output file is created, so there must be some of them
+		if (_is_data_authenticated and !index.chunks_count)
+		{
+			std::cout << "Cannot decode data, because, authenticated data has no chunks!\n" << std::endl;
+			return false;
+		}
+
+		std::string chunk_data;
+		for (uint64_t chunk = 0; _is_data_authenticated and chunk < index.chunks_count; ++chunk)
+		{
+			if (!_read_index_chunk(fin, index, chunk, header, chunk_data))
+			{
+				std::cout << "Cannot decode data, because, authentication tag of chunk [" << chunk << "] does not match!\n" << std::endl;
+				return false;
+			}
+		}
+	}
+
+	// Data with one tag is checked in the same pass as it is decrypted. It goes to a file aside,
+	// which gets the name of the output only when the tag matches, so the changed data never becomes the output
+	bool is_checked_in_pass = _is_data_authenticated and !_is_data_indexed;
+	std::string decoded_filepath = is_checked_in_pass ? std::string(output_filepath) + ".tmp" : std::string(output_filepath);
+	uint64_t tag{};
+
+	if (is_checked_in_pass)
+	{
+		char tag_bytes[DES_MAC_SIZE];
+		bool is_tag_read = data_size >= DES_MAC_SIZE;
+		if (is_tag_read)
+		{
+			data_size -= DES_MAC_SIZE;
+			fin.clear();
+			fin.seekg(DES_HEADER_SIZE + data_size);
+			fin.read(tag_bytes, DES_MAC_SIZE);
+			is_tag_read = fin.gcount() == DES_MAC_SIZE;
+		}
+
+		if (!is_tag_read)
+		{
+			std::cout << "Cannot decode data, because, authentication tag does not match!\n" << std::endl;
+			return false;
+		}
+		tag = _bytes_to_block(tag_bytes);
+	}
+
+	fin.clear();
+	fin.seekg(DES_HEADER_SIZE);
+
+	std::ofstream fout(decoded_filepath, std::ios::binary);
+	if (!fout.is_open())
+	{
+		std::cout << "Cannot open file [" << decoded_filepath << "] to decrypt!\n" << std::endl;
+		return false;
+	}
+
+	auto remove_output = [&fout, &decoded_filepath]()
+		{
+			std::error_code error;
+			fout.close();
+			std::filesystem::remove(decoded_filepath, error);
+			return false;
+		};
+
+	DESCMAC mac(_get_mac_key_schedule());
+
+	bool is_parallel = _is_data_indexed or _is_parallel_mode(DES_DECODE);
+	size_t workers_count = is_parallel ? _get_threads_count() : 1;
+	ncommon::Pipeline pipeline(workers_count, 2 * workers_count + 2);
+
+	// Pieces of indexed data are whole chunks
+	size_t piece_size = _is_data_indexed ? DES_STREAM_CHUNK_SIZE - DES_STREAM_CHUNK_SIZE % index.chunk_size : DES_STREAM_CHUNK_SIZE;
+
+	std::string pending_data;
+	size_t output_size{};
+	uint64_t remaining_size{ data_size };
+	uint64_t block_position{};
+	uint64_t previous_block{ _data_iv };
+	uint64_t chaining_block{ _data_iv };
+
+	auto read_piece = [&](ncommon::pipeline_buffer& buffer)
+		{
+			if (!fin)
+				return false;
+
+			size_t read_size = static_cast<size_t>(std::min<uint64_t>(piece_size, remaining_size));
+			buffer.input.assign(pending_data);
+			buffer.input.resize(pending_data.size() + read_size);
+			fin.read(buffer.input.data() + pending_data.size(), read_size);
+			buffer.input.resize(pending_data.size() + static_cast<size_t>(fin.gcount()));
+			remaining_size -= static_cast<uint64_t>(fin.gcount());
+
+			// Tag is taken from the very bytes which are decrypted
+			if (is_checked_in_pass)
+				mac.update(buffer.input.data() + pending_data.size(), static_cast<size_t>(fin.gcount()));
+
+			// Only the last piece has the padding
+			buffer.is_last = !fin or remaining_size == 0;
+
+			size_t whole_size = buffer.input.size() - buffer.input.size() % 8;
+			pending_data.assign(buffer.input, whole_size);
+			buffer.input.resize(whole_size);
+
+			// Chain of the piece: counter for CTR mode, the encoded block before the piece for CBC and CFB,
+			// the first block of the piece for indexed data
+			if (_is_data_indexed)
+				buffer.context = block_position;
+			else
+				buffer.context = (_data_mode == DES_MODE_CTR) ? _data_iv + block_position : previous_block;
+			if (whole_size)
+				previous_block = _bytes_to_block(buffer.input.data() + whole_size - 8);
+
+			block_position += whole_size / 8;
+			return true;
+		};
+
+	auto decrypt_piece = [&](ncommon::pipeline_buffer& buffer)
+		{
+			buffer.output.resize(buffer.input.size());
+
+			if (_is_data_indexed)
+			{
+				_encrypt_index_chunks(buffer.input.data(), buffer.output.data(), buffer.input.size(), index.chunk_size, DES_DECODE, buffer.context);
+				return;
+			}
+
+			uint64_t last_chaining_block = _encrypt_chunks(buffer.input.data(), buffer.output.data(), buffer.input.size() / 8, DES_DECODE, is_parallel ? buffer.context : chaining_block);
+
+			if (!is_parallel)
+				chaining_block = last_chaining_block;
+		};
+
+	auto write_piece = [&](ncommon::pipeline_buffer& buffer)
+		{
+			if (buffer.is_last)
+				_remove_padding(buffer.output);
+
+			fout.write(buffer.output.data(), buffer.output.size());
+			output_size += buffer.output.size();
+			return static_cast<bool>(fout);
+		};
+
+	if (!pipeline.run(read_piece, decrypt_piece, write_piece))
+	{
+		std::cout << "Cannot write file [" << decoded_filepath << "]!\n" << std::endl;
+		return remove_output();
+	}
+
+	if (is_checked_in_pass)
+	{
+		mac.update(header.data(), header.size());
+		if (mac.finish() != tag)
+		{
+			std::cout << "Cannot decode data, because, authentication tag does not match!\n" << std::endl;
+			return remove_output();
+		}
+
+		std::error_code error;
+		fout.close();
+		std::filesystem::rename(decoded_filepath, output_filepath, error);
+		if (!fout or error)
+		{
+			std::cout << "Cannot write file [" << output_filepath << "]!\n" << std::endl;
+			return remove_output();
+		}
+	}
+
+	if (!pending_data.empty())
+		std::cout << "Data length is not a multiple of 8 bytes, last [" << pending_data.size() << "] byte(-s) are ignored!" << std::endl;
+
+	_reset_data();
+	std::cout << "End decrypting using key [" << _keyword << "].\nOutput size is [" << output_size << "] byte(-es)." << std::endl;
+	std::cout << "Output file is [" << output_filepath << "]\n" << std::endl;
+	return true;
+}
+
+bool ndes::DES::decode_range(const char* const input_filepath, uint64_t offset, size_t size, std::string& output)
+{
+	output.clear();
+	std::ifstream fin(input_filepath, std::ios::binary);
+
+	if (!fin.is_open())
+	{
+		std::cout << "Cannot open file [" << input_filepath << "] to decrypt!\n" << std::endl;
+		return false;
+	}
+
+	if (_keyword.empty())
+		create_random_key();
+
+	std::string header(DES_HEADER_SIZE, '\0');
+	fin.read(header.data(), header.size());
+	header.resize(static_cast<size_t>(fin.gcount()));
+
+	if (!_parse_header(header))
+		return false;
+
+	des_index index{};
+	if (!_is_data_indexed or !_read_index(fin, index))
+	{
+		std::cout << "Cannot decode a range of data, because, the data has no valid index!\n" << std::endl;
+		return false;
+	}
+
+	_create_sub_keys();
+
+	// Range is cut at the end of the data without the padding
+	uint64_t decoded_size = index.data_size - std::min<uint64_t>(_padding_counter, index.data_size);
+	if (offset >= decoded_size or !size)
+		return true;
+
+	uint64_t end = offset + std::min<uint64_t>(size, decoded_size - offset);
+	uint64_t first_chunk = offset / index.chunk_size;
+	uint64_t chunks_count = (end - 1) / index.chunk_size + 1 - first_chunk;
+
+	// Every chunk of the range is read and checked before anything is decrypted
+	std::string data, chunk_data;
+	for (uint64_t chunk = first_chunk; chunk < first_chunk + chunks_count; ++chunk)
+	{
+		if (!_read_index_chunk(fin, index, chunk, header, chunk_data))
+		{
+			std::cout << "Cannot decode data, because, chunk [" << chunk << "] is invalid or its authentication tag does not match!\n" << std::endl;
+			return false;
+		}
+		data += chunk_data;
+	}
+
+	_parallel_for(static_cast<size_t>(chunks_count), [this, &data, &index, first_chunk](size_t chunk)
+		{
+			size_t chunk_offset = chunk * index.chunk_size;
+			size_t chunk_size = std::min<size_t>(index.chunk_size, data.size() - chunk_offset);
+
+			_encrypt_index_chunks(data.data() + chunk_offset, data.data() + chunk_offset, chunk_size, index.chunk_size, DES_DECODE, (first_chunk + chunk) * index.chunk_size / 8);
+		}
+	);
+
+	output.assign(data, offset - first_chunk * index.chunk_size, end - offset);
+	return true;
 }
 
 void ndes::DES::_remove_non_ascii(std::string& source_data)
@@ -109,63 +626,121 @@ void ndes::DES::_remove_non_ascii(std::string& source_data)
 	source_data = ascii_string;
 }
 
-std::string ndes::DES::_int_to_bin(int16_t value)
+void ndes::DES::_add_padding(std::string& str)
 {
-	return std::bitset<4>(value).to_string();
+	while ((str.size() % 8) != 0)
+	{
+		str += _padding_symbol;
+		++_padding_counter;
+	}
 }
 
-int16_t ndes::DES::_bin_to_int(const std::string& bin)
+void ndes::DES::_remove_padding(std::string& str)
 {
-	return std::stoi(bin);
+	if (!str.size())
+		return;
+
+
+	str.resize(str.size() - std::min<size_t>(_padding_counter, str.size()));
 }
 
-std::string ndes::DES::_bin_xor(const std::string& bin1, const std::string& bin2)
+uint64_t ndes::DES::_bytes_to_block(const char* bytes)
 {
-	std::string bin(bin1.size(), '0');
+	// First byte goes to the most significant bits, as in the DES bit numbering
+	uint64_t block{};
+	for (int16_t i = 0; i < 8; ++i)
+		block = (block << 8) | static_cast<uint8_t>(bytes[i]);
+	return block;
+}
 
-	for (int16_t i = 0; i < bin1.size(); ++i)
-		bin[i] = (bin1[i] == bin2[i]) ? '0' : '1';
-	return bin;
+void ndes::DES::_block_to_bytes(uint64_t block, char* bytes)
+{
+	for (int16_t i = 7; i >= 0; --i, block >>= 8)
+		bytes[i] = static_cast<char>(block & 0xFF);
 }
 
-void ndes::DES::_add_padding(std::string& str)
+std::string ndes::DES::_create_header()
 {
-	while ((str.size() % 8) != 0)
+	// Magic, version, mode, padding size, flags and IV
+	std::string header(DES_HEADER_SIZE, '\0');
+
+	std::copy(DES_HEADER_MAGIC, DES_HEADER_MAGIC + 3, header.begin());
+	header[3] = DES_HEADER_VERSION;
+	header[4] = static_cast<char>(_data_mode);
+	header[5] = static_cast<char>(_padding_counter);
+	header[6] = (_is_data_authenticated ? DES_HEADER_FLAG_MAC : 0) | (_is_data_indexed ? DES_HEADER_FLAG_INDEX : 0);
+	_block_to_bytes(_data_iv, header.data() + 8);
+
+	return header;
+}
+
+bool ndes::DES::_parse_header(const std::string& data)
+{
+	if (data.size() < DES_HEADER_SIZE or !std::equal(DES_HEADER_MAGIC, DES_HEADER_MAGIC + 3, data.begin()))
 	{
-		str += _padding_symbol;
-		++_padding_counter;
+		std::cout << "Cannot decode data, because, it is not a DES encoded data!\n" << std::endl;
+		return false;
 	}
+
+	if (data[3] != DES_HEADER_VERSION or data[4] < DES_MODE_ECB or data[4] > DES_MODE_CTR or data[5] < 0 or data[5] >= 8 or (data[6] & ~(DES_HEADER_FLAG_MAC | DES_HEADER_FLAG_INDEX)) != 0)
+	{
+		std::cout << "Cannot decode data, because, header of the data is invalid!\n" << std::endl;
+		return false;
+	}
+
+	// Flag could be cleared together with the tag cut off, so the data without it is not trusted by an authenticated decoder
+	_is_data_authenticated = (data[6] & DES_HEADER_FLAG_MAC) != 0;
+	if (_is_authenticated and !_is_data_authenticated)
+	{
+		std::cout << "Cannot decode data, because, it has no authentication tag!\n" << std::endl;
+		return false;
+	}
+
+	// Encoded data knows how to decode it, the settings of the caller stay for the next messages
+	_data_mode = data[4];
+	_padding_counter = data[5];
+	_is_data_indexed = (data[6] & DES_HEADER_FLAG_INDEX) != 0;
+	_data_iv = _bytes_to_block(data.data() + 8);
+
+	return true;
 }
 
-void ndes::DES::_remove_padding(std::string& str)
+void ndes::DES::_init_message(bool is_random_iv)
 {
-	if (!str.size())
-		return;
+	_data_mode = _mode;
+	_is_data_indexed = _is_indexed;
+	_is_data_authenticated = _is_authenticated;
+	_padding_counter = 0;
 
+	// Same IV with the same key gives the same output for the same start of the data, so every message gets its own
+	_data_iv = (is_random_iv and !_is_iv_set and _mode != DES_MODE_ECB) ? _create_random_iv() : _iv;
+}
 
-	str = str.substr(0, str.size() - _padding_counter);
+uint64_t ndes::DES::_create_random_iv()
+{
+	std::random_device random_device;
+	return (static_cast<uint64_t>(random_device()) << 32) | random_device();
 }
 
-std::string ndes::DES::_permutate(const std::string& binary_str, std::vector<data_type> permutation_table)
+uint64_t ndes::DES::_permutate(uint64_t value, const permutation_lookup_type& permutation_lookup, int16_t input_size)
 {
-	std::string permuted_str;
-	permuted_str.reserve(permutation_table.size());
+	uint64_t permuted_value{};
 
-	for (int16_t i = 0; i < permutation_table.size(); ++i)
-		permuted_str += binary_str[permutation_table[i]];
-	return permuted_str;
+	for (int16_t i = 0, shift = input_size - 8; shift >= 0; ++i, shift -= 8)
+		permuted_value |= permutation_lookup[i][(value >> shift) & 0xFF];
+	return permuted_value;
 }
 
-void ndes::DES::_make_cyclic_shift(std::string& binary_str, int16_t shift_size)
+uint32_t ndes::DES::_make_cyclic_shift(uint32_t half_key, int16_t shift_size)
 {
-	std::rotate(binary_str.begin(), binary_str.begin() + shift_size, binary_str.end());
+	// Halves of the key are 28 bits long
+	return ((half_key << shift_size) | (half_key >> (DES_KEY_BINSIZE / 2 - shift_size))) & 0x0FFFFFFF;
 }
 
 void ndes::DES::_reset_data()
 {
 	_source_data.clear();
 	_result_data.clear();
-	_keys_n.clear();
 }
 
 void ndes::DES::_write_result(int16_t crypt_type)
@@ -174,14 +749,25 @@ void ndes::DES::_write_result(int16_t crypt_type)
 	std::string filepath = (crypt_type == DES_ENCODE) ? DES_ENCODED_OUTPUT : DES_DECODED_OUTPUT;
 	std::string type = (crypt_type == DES_ENCODE) ? "encrypting" : "decrypting";
 
-	fout.open(filepath);
+	fout.open(filepath, std::ios::binary);
 	if (!fout.is_open())
 	{
 		std::cout << "Cannot open file [" << filepath << "] to write [" << type << "] results!\nOutput here:\n" << std::endl;
 		std::cout << _result_data << std::endl;
 		return;
 	}
+
+	if (crypt_type == DES_ENCODE)
+		fout << _create_header();
 	fout << _result_data;
+
+	// Empty data has a tag too, it covers the header
+	if (crypt_type == DES_ENCODE and _is_data_authenticated)
+	{
+		char tag[DES_MAC_SIZE];
+		_block_to_bytes(_mac_tag, tag);
+		fout.write(tag, DES_MAC_SIZE);
+	}
 	fout.close();
 	std::cout << "End " << type << " using key [" << _keyword << "].\nInput size is [" << _result_data.size() << "] byte(-es)." << std::endl;
 	std::cout << "Output file is [" << filepath << "]\n" << std::endl;
@@ -194,7 +780,7 @@ void ndes::DES::_print_init(int16_t crypt_type)
 	std::cout << "Start " << type << " using key [" << _keyword << "].\nInput size is [" << _source_data.size() - size << "] byte(-es).\n" << std::endl;
 }
 
-void ndes::DES::_encrypt(int16_t crypt_type)
+bool ndes::DES::_encrypt(int16_t crypt_type)
 {
 	if (_keyword.empty())
 		create_random_key();
@@ -204,132 +790,595 @@ void ndes::DES::_encrypt(int16_t crypt_type)
 		if (crypt_type == DES_ENCODE)
 		{
 			std::cout << "You need to specify source data file!\n" << std::endl;
-			return;
+			return false;
 		}
 
 		if (!open_data_file(DES_ENCODED_OUTPUT))
-			return;
+			return false;
 
 		if (!_source_data.size())
-			return;
+			return false;
+	}
+
+	if (crypt_type == DES_ENCODE and _is_data_indexed)
+	{
+		std::cout << "Indexed data is written only by encode_file()!\n" << std::endl;
+		return false;
 	}
 
-	if ((_source_data.size() % 8) != 0)
+	std::string header;
+	uint64_t tag{};
+
+	if (crypt_type == DES_DECODE)
 	{
-		if (crypt_type == DES_DECODE)
+		if (!_parse_header(_source_data))
+			return false;
+
+		if (_is_data_indexed)
+		{
+			std::cout << "Cannot decode data, because, indexed data is read only by decode_file() and decode_range()!\n" << std::endl;
+			return false;
+		}
+
+		header = _source_data.substr(0, DES_HEADER_SIZE);
+		_source_data.erase(0, DES_HEADER_SIZE);
+
+		if (_is_data_authenticated and _source_data.size() >= DES_MAC_SIZE)
+		{
+			tag = _bytes_to_block(_source_data.data() + _source_data.size() - DES_MAC_SIZE);
+			_source_data.resize(_source_data.size() - DES_MAC_SIZE);
+		}
+
+		if ((_source_data.size() % 8) != 0)
 		{
 			std::cout << "Cannot decode data, because, invalid data length, data must be a multiple of 8 bytes!" << std::endl;
-			return;
+			return false;
 		}
+	}
+	else
+	{
+		// Work ONLY with ASCII
+		_remove_non_ascii(_source_data);
 
-		// Else is encoder, so we need to add paddings
+		// Encoder needs a multiple of 8 bytes, so we need to add paddings
 		_add_padding(_source_data);
 	}
 
-	// Work ONLY with ASCII
-	if (crypt_type == DES_ENCODE)
-		_remove_non_ascii(_source_data);
-
 	_print_init(crypt_type);
 	_create_sub_keys();
 
-	int16_t block_size = (crypt_type == DES_ENCODE) ? 8 : 64;
-	std::string left_subblock, right_subblock;
+	_chaining_block = _data_iv;
+	_stream_position = 0;
 
-	// Main part of the encryption algorithm
-	for (int32_t k = 0; k < _source_data.size(); k += block_size)
+	if (!_is_data_authenticated)
+		_encrypt_data(crypt_type);
+	else if (crypt_type == DES_ENCODE)
 	{
-		std::string block_of_data = (crypt_type == DES_ENCODE) ? _ascii_to_bin(_source_data.substr(k, block_size)) : _source_data.substr(k, block_size);
-		block_of_data = _permutate(block_of_data, _initial_permutation);
+		DESCMAC mac(_get_mac_key_schedule());
 
-		left_subblock = block_of_data.substr(0, 32);
-		right_subblock = block_of_data.substr(32, 32);
+		_result_data.resize(_source_data.size());
+		_encrypt_data(_source_data.data(), _result_data.data(), _source_data.size() / 8, mac);
 
-		// Encryption starts from Kn[1] through to Kn[16]
-		int16_t iteration{ 0 }, iteration_adjustment{ 1 };
+		header = _create_header();
+		mac.update(header.data(), header.size());
+		_mac_tag = mac.finish();
+	}
+	else
+	{
+		// Tag of the encoded data and the header is checked before anything is decrypted
+		DESCMAC mac(_get_mac_key_schedule());
+		mac.update(_source_data.data(), _source_data.size());
+		mac.update(header.data(), header.size());
 
-		// Decryption starts from Kn[16] down to Kn[1]
-		if (crypt_type == DES_DECODE)
+		if (mac.finish() != tag)
 		{
-			iteration = 15;
-			iteration_adjustment = -1;
+			std::cout << "Cannot decode data, because, authentication tag does not match!\n" << std::endl;
+			return false;
 		}
+		_encrypt_data(crypt_type);
+	}
 
-		std::string temp_right_subkey;
-		std::vector<std::string> mini_blocks;
-		std::string bn;
+	if (crypt_type == DES_DECODE)
+		_remove_padding(_result_data);
+	return true;
+}
 
-		for (int16_t i = 0; i < 16; ++i, iteration += iteration_adjustment)
-		{
-			bn.clear();
-			mini_blocks.clear();
+bool ndes::DES::_encrypt_span(std::span<const uint8_t> input, std::span<uint8_t> output, int16_t crypt_type, DESCMAC* mac)
+{
+	if ((input.size() % 8) != 0 or output.size() < input.size())
+		return false;
 
-			// Make a copy of R[i - 1], this will later become L[i]
-			temp_right_subkey = right_subblock;
+	const char* input_data = reinterpret_cast<const char*>(input.data());
+	char* output_data = reinterpret_cast<char*>(output.data());
 
-			// Permutate R[i - 1] to start creating R[i]
-			right_subblock = _permutate(right_subblock, _expansion_table);
+	// Blocks are processed in place, only a partial overlap would break them
+	if (input_data != output_data and input_data < output_data + input.size() and output_data < input_data + input.size())
+		return false;
 
-			right_subblock = _bin_xor(right_subblock, _keys_n[iteration]);
+	// Every call is a message with the settings of the caller, its IV is not stored anywhere
+	_init_message(false);
+	_create_sub_keys();
+	_chaining_block = _data_iv;
+	_stream_position = 0;
 
-			// Create Bi
-			for (int16_t j = 0; j < 8; ++j)
-				mini_blocks.push_back(right_subblock.substr(6 * j, 6));
+	if (mac)
+		_encrypt_data(input_data, output_data, input.size() / 8, *mac);
+	else
+		_encrypt_data(input_data, output_data, input.size() / 8, crypt_type);
+	return true;
+}
 
-			// Permutate B[1] to B[8] using the S - Boxes
-			for (int16_t j = 0; j < 8; ++j)
-			{
+bool ndes::DES::_encrypt_batch(std::span<const des_record> records, int16_t crypt_type)
+{
+	size_t blocks_count{};
+	for (const auto& record : records)
+	{
+		if (record.key.size() != DES_KEY_SIZE or (record.data.size() % 8) != 0)
+			return false;
+		blocks_count += record.data.size() / 8;
+	}
 
-				// Work out the offsets
-				int16_t row{}, col{};
+	// Blocks of all records go in a row, every one with the key of its record
+	std::vector<uint64_t> blocks(blocks_count), keys(blocks_count);
 
-				for (int16_t ind = 0, sh = 1; ind < 6; ind += 5, --sh)
-					row += (static_cast<int16_t>(mini_blocks[j][ind] - '0') << sh);
+	size_t k{};
+	for (const auto& record : records)
+	{
+		uint64_t key = _bytes_to_block(reinterpret_cast<const char*>(record.key.data()));
 
-				for (int16_t ind = 1, sh = 3; ind < 5; ++ind, --sh)
-					col += (static_cast<int16_t>(mini_blocks[j][ind] - '0') << sh);
+		for (size_t offset = 0; offset < record.data.size(); offset += 8, ++k)
+		{
+			blocks[k] = _bytes_to_block(reinterpret_cast<const char*>(record.data.data()) + offset);
+			keys[k] = key;
+		}
+	}
 
-				// Find the permutation value
-				int16_t value = _sbox[j][row * 16 + col];
+	// Whole bitsliced passes are shared among the threads, the rest is done block by block
+	size_t sliced_count = blocks_count - blocks_count % DESBitslice::blocks_per_pass();
+	size_t chunks_count = (sliced_count + DES_CHUNK_BLOCKS - 1) / DES_CHUNK_BLOCKS;
 
-				bn += _int_to_bin(value);
-			}
+	_parallel_for(chunks_count, [&blocks, &keys, sliced_count, crypt_type](size_t chunk)
+		{
+			size_t first_block = chunk * DES_CHUNK_BLOCKS;
+			DESBitslice::crypt_blocks(blocks.data() + first_block, keys.data() + first_block, std::min(DES_CHUNK_BLOCKS, sliced_count - first_block), crypt_type);
+		}
+	);
 
-			// Permutate the concatination of B[1] to B[8] (Bn)
-			right_subblock = _permutate(bn, _permutation2);
+	// Blocks of one record are next to each other, so the schedule is made once per record
+	std::unique_ptr<DESKeySchedule> key_schedule;
+	for (k = sliced_count; k < blocks_count; ++k)
+	{
+		if (!key_schedule or keys[k] != keys[k - 1])
+		{
+			std::string key(DES_KEY_SIZE, '\0');
+			_block_to_bytes(keys[k], key.data());
+			key_schedule = std::make_unique<DESKeySchedule>(key);
+		}
+		blocks[k] = _encrypt_block(blocks[k], key_schedule->stages(crypt_type), key_schedule->stages_count());
+	}
 
-			// Xor with L[i - 1]
-			right_subblock = _bin_xor(right_subblock, left_subblock);
+	k = 0;
+	for (const auto& record : records)
+		for (size_t offset = 0; offset < record.data.size(); offset += 8, ++k)
+			_block_to_bytes(blocks[k], reinterpret_cast<char*>(record.data.data()) + offset);
 
-			// L[i] becomes R[i - 1]
-			left_subblock = temp_right_subkey;
+	return true;
+}
+
+void ndes::DES::_encrypt_data(int16_t crypt_type)
+{
+	size_t blocks_count = _source_data.size() / 8;
+
+	// Every chunk writes its result straight to its place
+	_result_data.resize(blocks_count * 8);
+	_encrypt_data(_source_data.data(), _result_data.data(), blocks_count, crypt_type);
+}
+
+void ndes::DES::_encrypt_data(const char* input, char* output, size_t blocks_count, int16_t crypt_type)
+{
+	size_t chunks_count = (blocks_count + DES_CHUNK_BLOCKS - 1) / DES_CHUNK_BLOCKS;
+
+	if (!blocks_count)
+		return;
+
+	// Main part of the encryption algorithm
+	if (_is_parallel_mode(crypt_type))
+	{
+		// Next data continues from the last encoded block
+		uint64_t last_block = _bytes_to_block(input + (blocks_count - 1) * 8);
+
+		if (chunks_count == 1)
+			_encrypt_chunk(input, output, blocks_count, crypt_type, _get_chaining_block(input, 0));
+		else
+		{
+			// Chains are taken before any chunk starts, since the output may overwrite the input
+			std::vector<uint64_t> chaining_blocks(chunks_count);
+			for (size_t chunk = 0; chunk < chunks_count; ++chunk)
+				chaining_blocks[chunk] = _get_chaining_block(input, chunk * DES_CHUNK_BLOCKS);
+
+			_parallel_for(chunks_count, [this, input, output, blocks_count, crypt_type, &chaining_blocks](size_t chunk)
+				{
+					size_t first_block = chunk * DES_CHUNK_BLOCKS;
+					size_t chunk_size = std::min(DES_CHUNK_BLOCKS, blocks_count - first_block);
+
+					_encrypt_chunk(input + first_block * 8, output + first_block * 8, chunk_size, crypt_type, chaining_blocks[chunk]);
+				}
+			);
 		}
 
-		// Final permutation of R[16]L[16]
-		_result_data += _permutate(right_subblock + left_subblock, _final_permutation);
+		_chaining_block = last_block;
+	}
+	else
+	{
+		_chaining_block = _encrypt_chunks(input, output, blocks_count, crypt_type, _chaining_block);
 	}
 
-	if (crypt_type == DES_DECODE)
+	_stream_position += blocks_count;
+}
+
+void ndes::DES::_encrypt_data(const char* input, char* output, size_t blocks_count, DESCMAC& mac)
+{
+	// MAC of every group of chunks is taken while the group is still in the cache, so the data is passed once
+	size_t group_blocks = DES_CHUNK_BLOCKS * _get_threads_count();
+
+	for (size_t first_block = 0; first_block < blocks_count; first_block += group_blocks)
 	{
-		_result_data = _bin_to_ascii(_result_data);
-		_remove_padding(_result_data);
+		size_t group_size = std::min(group_blocks, blocks_count - first_block);
+
+		_encrypt_data(input + first_block * 8, output + first_block * 8, group_size, DES_ENCODE);
+		mac.update(output + first_block * 8, group_size * 8);
 	}
 }
 
-void ndes::DES::_create_sub_keys()
+uint64_t ndes::DES::_encrypt_chunks(const char* input, char* output, size_t blocks_count, int16_t crypt_type, uint64_t chaining_block)
+{
+	// Every chunk continues the chain of the previous one
+	for (size_t first_block = 0; first_block < blocks_count; first_block += DES_CHUNK_BLOCKS)
+		chaining_block = _encrypt_chunk(input + first_block * 8, output + first_block * 8, std::min(DES_CHUNK_BLOCKS, blocks_count - first_block), crypt_type, chaining_block);
+	return chaining_block;
+}
+
+bool ndes::DES::_is_parallel_mode(int16_t crypt_type)
+{
+	// Modes where no block depends on the result of the previous one
+	switch (_data_mode)
+	{
+	case DES_MODE_CBC:
+	case DES_MODE_CFB:
+		return crypt_type == DES_DECODE;
+
+	case DES_MODE_OFB:
+		return false;
+
+	default:
+		return true;
+	}
+}
+
+uint64_t ndes::DES::_get_chaining_block(const char* input, size_t first_block)
+{
+	switch (_data_mode)
+	{
+	case DES_MODE_CBC:
+	case DES_MODE_CFB:
+		// Decoder chains with the previous encoded block, which is the input
+		return (first_block == 0) ? _chaining_block : _bytes_to_block(input + (first_block - 1) * 8);
+
+	case DES_MODE_CTR:
+		return _data_iv + _stream_position + first_block;
+
+	default:
+		return _chaining_block;
+	}
+}
+
+uint64_t ndes::DES::_encrypt_chunk(const char* input, char* output, size_t blocks_count, int16_t crypt_type, uint64_t chaining_block)
 {
-	std::string temp_key = _permutate(_ascii_to_bin(_keyword), _permuted_choice_key1);
+	// Whole chunk is loaded before anything is stored, so the output may be the input
+	uint64_t blocks[DES_CHUNK_BLOCKS];
+	for (size_t k = 0; k < blocks_count; ++k)
+		blocks[k] = _bytes_to_block(input + k * 8);
 
-	std::string left_subkey = temp_key.substr(0, DES_KEY_BINSIZE / 2);
-	std::string right_subkey = temp_key.substr(DES_KEY_BINSIZE / 2, DES_KEY_BINSIZE / 2);
+	switch (_data_mode)
+	{
+	case DES_MODE_CBC:
+		chaining_block = _encrypt_cbc(input, blocks, blocks_count, crypt_type, chaining_block);
+		break;
+
+	case DES_MODE_CFB:
+		chaining_block = _encrypt_cfb(input, blocks, blocks_count, crypt_type, chaining_block);
+		break;
+
+	case DES_MODE_OFB:
+		chaining_block = _encrypt_ofb(blocks, blocks_count, chaining_block);
+		break;
+
+	case DES_MODE_CTR:
+		chaining_block = _encrypt_ctr(input, blocks, blocks_count, chaining_block);
+		break;
+
+	default:
+		_encrypt_blocks(blocks, blocks_count, crypt_type);
+		break;
+	}
+
+	for (size_t k = 0; k < blocks_count; ++k)
+		_block_to_bytes(blocks[k], output + k * 8);
+
+	return chaining_block;
+}
+
+void ndes::DES::_encrypt_blocks(uint64_t* blocks, size_t blocks_count, int16_t crypt_type)
+{
+	size_t k{};
+
+	// Large inputs go through the bitsliced engine when its kernel is faster on this CPU, the rest is done block by block
+	if (blocks_count >= DES_BITSLICE_MIN_BLOCKS and DESBitslice::is_faster())
+	{
+		k = blocks_count - blocks_count % DESBitslice::blocks_per_pass();
+		DESBitslice::crypt_blocks(blocks, k, _key_schedule->stages(crypt_type), _key_schedule->stages_count());
+	}
+
+	for (; k < blocks_count; ++k)
+		blocks[k] = _encrypt_block(blocks[k], crypt_type);
+}
+
+uint64_t ndes::DES::_encrypt_cbc(const char* input, uint64_t* blocks, size_t blocks_count, int16_t crypt_type, uint64_t previous_block)
+{
+	if (crypt_type == DES_ENCODE)
+	{
+		// C[i] = E(P[i] xor C[i - 1]), every block depends on the previous one
+		for (size_t k = 0; k < blocks_count; ++k)
+			previous_block = blocks[k] = _encrypt_block(blocks[k] ^ previous_block, DES_ENCODE);
+		return previous_block;
+	}
+
+	// P[i] = D(C[i]) xor C[i - 1], all D(C[i]) are independent. Every C[i] is still in the input
+	_encrypt_blocks(blocks, blocks_count, DES_DECODE);
+
+	for (size_t k = 0; k < blocks_count; ++k)
+	{
+		blocks[k] ^= previous_block;
+		previous_block = _bytes_to_block(input + k * 8);
+	}
+	return previous_block;
+}
+
+uint64_t ndes::DES::_encrypt_cfb(const char* input, uint64_t* blocks, size_t blocks_count, int16_t crypt_type, uint64_t previous_block)
+{
+	if (crypt_type == DES_ENCODE)
+	{
+		// C[i] = P[i] xor E(C[i - 1])
+		for (size_t k = 0; k < blocks_count; ++k)
+			previous_block = blocks[k] ^= _encrypt_block(previous_block, DES_ENCODE);
+		return previous_block;
+	}
+
+	// P[i] = C[i] xor E(C[i - 1]), the ciphertext is known, so all E(C[i - 1]) are independent.
+	// Blocks become the key stream, the ciphertext is taken from the input again
+	for (size_t k = blocks_count - 1; k > 0; --k)
+		blocks[k] = blocks[k - 1];
+	blocks[0] = previous_block;
+
+	_encrypt_blocks(blocks, blocks_count, DES_ENCODE);
+
+	for (size_t k = 0; k < blocks_count; ++k)
+		blocks[k] ^= _bytes_to_block(input + k * 8);
+	return _bytes_to_block(input + (blocks_count - 1) * 8);
+}
+
+uint64_t ndes::DES::_encrypt_ofb(uint64_t* blocks, size_t blocks_count, uint64_t key_stream)
+{
+	// O[i] = E(O[i - 1]), the same for both directions
+	for (size_t k = 0; k < blocks_count; ++k)
+	{
+		key_stream = _encrypt_block(key_stream, DES_ENCODE);
+		blocks[k] ^= key_stream;
+	}
+	return key_stream;
+}
+
+uint64_t ndes::DES::_encrypt_ctr(const char* input, uint64_t* blocks, size_t blocks_count, uint64_t counter)
+{
+	// Key stream is E(IV + i), the same for both directions. Blocks become the key stream, the data is taken from the input again
+	for (size_t k = 0; k < blocks_count; ++k)
+		blocks[k] = counter + k;
+
+	_encrypt_blocks(blocks, blocks_count, DES_ENCODE);
+
+	for (size_t k = 0; k < blocks_count; ++k)
+		blocks[k] ^= _bytes_to_block(input + k * 8);
+	return counter + blocks_count;
+}
+
+size_t ndes::DES::_get_threads_count()
+{
+	return _threads_count ? _threads_count : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+ncommon::ThreadPool& ndes::DES::_get_thread_pool()
+{
+	size_t threads_count = _get_threads_count();
+
+	if (!_thread_pool or _thread_pool->size() != threads_count)
+		_thread_pool = std::make_shared<ncommon::ThreadPool>(threads_count);
+	return *_thread_pool;
+}
+
+void ndes::DES::_parallel_for(size_t tasks_count, const std::function<void(size_t)>& task)
+{
+	// Short data is done by the calling thread, the pool is made only when there is work for more threads
+	if (tasks_count < 2 or _get_threads_count() == 1)
+	{
+		for (size_t i = 0; i < tasks_count; ++i)
+			task(i);
+		return;
+	}
+
+	_get_thread_pool().parallel_for(tasks_count, task);
+}
 
+template<int16_t crypt_type>
+void ndes::DES::_encrypt_rounds(uint32_t& left_subblock, uint32_t& right_subblock, const uint64_t* keys_n)
+{
 	for (int16_t i = 0; i < 16; ++i)
 	{
-		_make_cyclic_shift(left_subkey, _cyclical_shifts[i]);
-		_make_cyclic_shift(right_subkey, _cyclical_shifts[i]);
+		// Encryption goes from Kn[1] through to Kn[16], decryption from Kn[16] down to Kn[1]
+		uint64_t key = keys_n[(crypt_type == DES_ENCODE) ? i : 15 - i];
+
+		// L[i] becomes R[i - 1], R[i] = L[i - 1] xor f(R[i - 1], Kn[i])
+		uint32_t temp_right_subblock = right_subblock;
+		right_subblock = left_subblock ^ _feistel(right_subblock, key);
+		left_subblock = temp_right_subblock;
+	}
+}
+
+uint64_t ndes::DES::_encrypt_block(uint64_t block, int16_t crypt_type)
+{
+	return _encrypt_block(block, _key_schedule->stages(crypt_type), _key_schedule->stages_count());
+}
+
+uint64_t ndes::DES::_encrypt_block(uint64_t block, const des_stage* stages, int16_t stages_count)
+{
+	block = _permutate(block, _initial_permutation_lookup, 64);
+
+	uint32_t left_subblock = static_cast<uint32_t>(block >> 32);
+	uint32_t right_subblock = static_cast<uint32_t>(block);
+
+	for (int16_t s = 0; s < stages_count; ++s)
+	{
+		// Final permutation of one stage and initial permutation of the next one cancel out, only R[16]L[16] swap is left
+		if (s != 0)
+			std::swap(left_subblock, right_subblock);
+
+		if (stages[s].crypt_type == DES_ENCODE)
+			_encrypt_rounds<DES_ENCODE>(left_subblock, right_subblock, stages[s].keys_n);
+		else
+			_encrypt_rounds<DES_DECODE>(left_subblock, right_subblock, stages[s].keys_n);
+	}
+
+	// Final permutation of R[16]L[16]
+	return _permutate((static_cast<uint64_t>(right_subblock) << 32) | left_subblock, _final_permutation_lookup, 64);
+}
+
+uint32_t ndes::DES::_feistel(uint32_t right_subblock, uint64_t key)
+{
+	// Expand R[i - 1] to 48 bits and xor with the round key
+	uint64_t expanded_block = _permutate(right_subblock, _expansion_table_lookup, 32) ^ key;
+	uint32_t result{};
+
+	// S - box lookup and permutation P in one step for every B[j]
+	for (int16_t j = 0; j < 8; ++j)
+		result |= _sp_table[j][(expanded_block >> (42 - 6 * j)) & 0x3F];
+	return result;
+}
+
+void ndes::DES::_create_sub_keys()
+{
+	// Single DES uses only the first 8 symbols of the keyword
+	std::string key = _is_triple ? _keyword : _keyword.substr(0, DES_KEY_SIZE);
+
+	if (_key_schedule and _key_schedule->key() == key)
+		return;
+
+	_key_schedule = _key_schedule_cache ? _key_schedule_cache->get(key) : std::make_shared<const DESKeySchedule>(key);
+}
+
+ndes::des_key_schedule_ptr ndes::DES::_get_mac_key_schedule()
+{
+	_create_sub_keys();
 
-		_keys_n.push_back(_permutate(left_subkey + right_subkey, _permuted_choice_key2));
+	if (_mac_key_schedule and _mac_key_source == _key_schedule)
+		return _mac_key_schedule;
+
+	// Own key for the MAC, derived from the keyword, so one key never does both jobs
+	std::string mac_key(_key_schedule->is_triple() ? DES_TRIPLE_KEY3_SIZE : DES_KEY_SIZE, '\0');
+	for (size_t k = 0; k < mac_key.size() / DES_KEY_SIZE; ++k)
+		_block_to_bytes(_encrypt_block(DES_MAC_KEY_LABEL + k, DES_ENCODE), mac_key.data() + k * DES_KEY_SIZE);
+
+	_mac_key_source = _key_schedule;
+	_mac_key_schedule = std::make_shared<const DESKeySchedule>(mac_key);
+	return _mac_key_schedule;
+}
+
+uint64_t ndes::DES::_get_index_chunk_iv(uint64_t first_block)
+{
+	// Counter just goes on, other modes start every chunk from its encrypted position
+	return (_data_mode == DES_MODE_CTR) ? _data_iv + first_block : _encrypt_block(_data_iv + first_block, DES_ENCODE);
+}
+
+void ndes::DES::_encrypt_index_chunks(const char* input, char* output, size_t size, size_t chunk_size, int16_t crypt_type, uint64_t first_block)
+{
+	for (size_t offset = 0; offset < size; offset += chunk_size)
+	{
+		uint64_t chunk_first_block = first_block + offset / 8;
+		_encrypt_chunks(input + offset, output + offset, std::min(chunk_size, size - offset) / 8, crypt_type, _get_index_chunk_iv(chunk_first_block));
 	}
 }
 
+uint64_t ndes::DES::_get_index_chunk_tag(const char* data, size_t size, uint64_t chunk, bool is_last, std::string header)
+{
+	// Padding size is known only for the last chunk, so the others have 0 there
+	header[5] = is_last ? static_cast<char>(_padding_counter) : 0;
+
+	char position[8];
+	_block_to_bytes(is_last ? chunk | DES_INDEX_LAST_CHUNK : chunk, position);
+
+	// Tag is bound to the chunk position, so the chunks cannot be swapped or cut off
+	DESCMAC mac(_get_mac_key_schedule());
+	mac.update(data, size);
+	mac.update(header.data(), header.size());
+	mac.update(position, sizeof(position));
+	return mac.finish();
+}
+
+bool ndes::DES::_read_index(std::istream& fin, des_index& index)
+{
+	fin.clear();
+	fin.seekg(0, std::ios::end);
+	uint64_t file_size = static_cast<uint64_t>(fin.tellg());
+
+	if (file_size < DES_HEADER_SIZE + DES_INDEX_TRAILER_SIZE)
+		return false;
 
+	char trailer[DES_INDEX_TRAILER_SIZE];
+	fin.seekg(file_size - DES_INDEX_TRAILER_SIZE);
+	fin.read(trailer, DES_INDEX_TRAILER_SIZE);
+
+	index.chunk_size = _bytes_to_block(trailer);
+	index.chunks_count = _bytes_to_block(trailer + 8);
+
+	// Chunk is whole blocks and not larger than a piece of the stream
+	uint64_t space_size = file_size - DES_HEADER_SIZE - DES_INDEX_TRAILER_SIZE;
+	if (!fin or !index.chunk_size or (index.chunk_size % 8) != 0 or index.chunk_size > DES_STREAM_CHUNK_SIZE or index.chunks_count > space_size / DES_INDEX_ENTRY_SIZE)
+		return false;
+
+	// All the chunks except the last one are full
+	index.data_size = space_size - index.chunks_count * DES_INDEX_ENTRY_SIZE;
+	return (index.data_size % 8) == 0 and (index.data_size + index.chunk_size - 1) / index.chunk_size == index.chunks_count;
+}
+
+bool ndes::DES::_read_index_chunk(std::istream& fin, const des_index& index, uint64_t chunk, const std::string& header, std::string& data)
+{
+	// Entry of the chunk: its offset in the file and its tag
+	char entry[DES_INDEX_ENTRY_SIZE];
+	fin.clear();
+	fin.seekg(DES_HEADER_SIZE + index.data_size + chunk * DES_INDEX_ENTRY_SIZE);
+	fin.read(entry, DES_INDEX_ENTRY_SIZE);
+
+	uint64_t offset = _bytes_to_block(entry);
+	uint64_t tag = _bytes_to_block(entry + 8);
+
+	bool is_last = (chunk + 1 == index.chunks_count);
+	size_t size = static_cast<size_t>(is_last ? index.data_size - chunk * index.chunk_size : index.chunk_size);
+
+	// Chunks lie one after another, so the decoders, which read the data in a row, decrypt only the checked bytes
+	if (!fin or offset != DES_HEADER_SIZE + chunk * index.chunk_size)
+		return false;
+
+	data.resize(size);
+	fin.seekg(offset);
+	fin.read(data.data(), size);
+
+	return fin and (!_is_data_authenticated or _get_index_chunk_tag(data.data(), size, chunk, is_last, header) == tag);
+}
@@ -1,25 +1,113 @@
 #pragma once
 
+#include <cstdint>
+
+#include <array>
+#include <iosfwd>
+#include <memory>
+#include <span>
 #include <vector>
 #include <string>
 
+#include "../common/Pipeline.hpp"
+#include "../common/ThreadPool.hpp"
+
 namespace ndes
 {
 	using data_type = uint8_t;
+	using sp_table_type = std::array<std::array<uint32_t, 64>, 8>;
+	using permutation_lookup_type = std::array<std::array<uint64_t, 256>, 8>;
 
 	constexpr int16_t DES_ENCODE = 0;
 	constexpr int16_t DES_DECODE = 1;
 
+	// Block cipher modes
+	constexpr int16_t DES_MODE_ECB = 0;
+	constexpr int16_t DES_MODE_CBC = 1;
+	constexpr int16_t DES_MODE_CFB = 2;
+	constexpr int16_t DES_MODE_OFB = 3;
+	constexpr int16_t DES_MODE_CTR = 4;
+
+	// Bytes of the source data read at once by the file streaming
+	constexpr size_t DES_STREAM_CHUNK_SIZE = 1 << 19;
+
+	// Blocks in one piece of work for a thread, a multiple of any bitsliced pass
+	constexpr size_t DES_CHUNK_BLOCKS = 8192;
+
 	constexpr int16_t DES_KEY_SIZE = 8;
+	constexpr int16_t DES_TRIPLE_KEY2_SIZE = 16;
+	constexpr int16_t DES_TRIPLE_KEY3_SIZE = 24;
 	constexpr int16_t DES_KEY_BINSIZE = 56;
 	constexpr int16_t DES_KEY_RANDOM_SEED = 67345;
 
-	const char* const DES_ENCODED_OUTPUT = "encoded_data.txt";
+	// Encoded data starts with a header: "DES", version, mode, padding size, flags and 8 bytes IV
+	const char* const DES_HEADER_MAGIC = "DES";
+	constexpr char DES_HEADER_VERSION = 1;
+	constexpr size_t DES_HEADER_SIZE = 16;
+
+	// Authenticated data ends with the CMAC tag of the encoded data and the header
+	constexpr char DES_HEADER_FLAG_MAC = 1;
+
+	// MAC key is the encryption of these blocks (one per key) with the keyword
+	constexpr uint64_t DES_MAC_KEY_LABEL = 0x4D41432D4B455930;
+
+	// Indexed data: every chunk has its own chain, so any chunk can be decrypted alone.
+	// Chunks are followed by the index (offset and tag of every chunk), the chunk size and the count of chunks
+	constexpr char DES_HEADER_FLAG_INDEX = 2;
+	constexpr size_t DES_INDEX_CHUNK_SIZE = 1 << 16;
+	constexpr size_t DES_INDEX_ENTRY_SIZE = 16;
+	constexpr size_t DES_INDEX_TRAILER_SIZE = 16;
+
+	// Position of the last chunk in its tag has this bit, so the data cannot be cut at a chunk border
+	constexpr uint64_t DES_INDEX_LAST_CHUNK = uint64_t{ 1 } << 63;
+
+	const char* const DES_ENCODED_OUTPUT = "encoded_data.bin";
 	const char* const DES_DECODED_OUTPUT = "decoded_data.txt";
 
 
+	// One DES pass of a block: 16 round keys and the direction to apply them.
+	// Key planes are the bits of the round keys as words of all zeros or all ones, 48 for every round
+	struct des_stage
+	{
+		const uint64_t* keys_n;
+		int16_t crypt_type;
+		const uint64_t* key_planes;
+	};
+
+
+	// One record of a batch: 8 bytes key and the data encrypted in place, a multiple of 8 bytes
+	struct des_record
+	{
+		std::span<const uint8_t> key;
+		std::span<uint8_t> data;
+	};
+
+
+	// Layout of an indexed file, sizes in bytes
+	struct des_index
+	{
+		uint64_t chunk_size;
+		uint64_t chunks_count;
+
+		// Encoded data between the header and the index
+		uint64_t data_size;
+	};
+
+
+	class DESCMAC;
+	class DESKeySchedule;
+	class DESKeyScheduleCache;
+
+	// Schedules are immutable, so one of them may be shared by any count of DES objects and threads
+	using des_key_schedule_ptr = std::shared_ptr<const DESKeySchedule>;
+
+
 	class DES
 	{
+		friend class DESBitslice;
+		friend class DESCMAC;
+		friend class DESKeySchedule;
+
 	public:
 		DES() {};
 		DES(const std::string& keyword) { set_keyword(keyword); };
@@ -31,50 +119,179 @@ namespace ndes
 		std::string create_random_key();
 
 		void set_keyword(const std::string& keyword);
+
+		// Triple DES EDE, 16 symbols keyword for two keys and 24 symbols for three keys
+		void set_triple_keyword(const std::string& keyword);
 		void set_padding_symbol(char symbol) { _padding_symbol = symbol; }
 
+		// Files and encode() get a fresh random IV for every message in the modes with a chain, unless it is set here.
+		// IV goes to the header, so decoders take it from there
+		void set_mode(int16_t mode) { _mode = mode; }
+		void set_iv(uint64_t iv) { _iv = iv; _is_iv_set = true; }
+
+		// Encoded files get a CMAC tag, decoders check it before any output.
+		// Authenticated decoders reject the data without a tag, others check the tag when the header has it
+		void set_authenticated(bool is_authenticated) { _is_authenticated = is_authenticated; }
+
+		// encode_file() writes the indexed format, which decode_range() reads without decrypting the whole file.
+		// Authenticated indexed files have a tag for every chunk instead of one for the file
+		void set_indexed(bool is_indexed) { _is_indexed = is_indexed; }
+
+		// 0 threads means one thread per core
+		void set_threads_count(size_t threads_count) { _threads_count = threads_count; }
+
+		// Round keys of the current keyword, built on the first call
+		des_key_schedule_ptr get_key_schedule();
+
+		// Uses a ready schedule instead of the keyword, the keyword becomes the key of the schedule
+		void set_key_schedule(des_key_schedule_ptr key_schedule);
+
+		// Schedules of new keywords are taken from the cache, nullptr turns the cache off
+		void set_key_schedule_cache(std::shared_ptr<DESKeyScheduleCache> key_schedule_cache) { _key_schedule_cache = std::move(key_schedule_cache); }
+
 		void encode();
 		void decode();
 
-	private:
-		std::string _ascii_to_bin(const std::string& str);
-		std::string _bin_to_ascii(const std::string& bin);
+		// In-memory encryption with the current keyword, mode and IV, without files and console output.
+		// Input must be a multiple of 8 bytes, output at least as large as input, both may be the same memory.
+		// Every call is a separate message that starts from the IV, no padding is added or removed.
+		bool encrypt(std::span<const uint8_t> input, std::span<uint8_t> output);
+		bool decrypt(std::span<const uint8_t> input, std::span<uint8_t> output);
 
-		void _remove_non_ascii(std::string& source_data);
+		// Same with a CMAC tag of the encoded data, it is taken in the same pass as the encryption.
+		// Decryption does not touch the output when the tag does not match
+		bool encrypt_and_mac(std::span<const uint8_t> input, std::span<uint8_t> output, uint64_t& tag);
+		bool decrypt_and_verify(std::span<const uint8_t> input, std::span<uint8_t> output, uint64_t tag);
+
+		// Many small records with their own keys in ECB mode, blocks of different records share the bitsliced passes.
+		// Keyword, mode and IV are not used, nothing is changed if any record is invalid.
+		bool encrypt_batch(std::span<const des_record> records);
+		bool decrypt_batch(std::span<const des_record> records);
 
-		std::string _int_to_bin(int16_t value);
-		int16_t _bin_to_int(const std::string& bin);
+		// Streaming versions, memory use does not depend on the file size.
+		// Reading, encryption and writing of the pieces run in a pipeline at the same time
+		bool encode_file(const char* const input_filepath, const char* const output_filepath = DES_ENCODED_OUTPUT);
+		bool decode_file(const char* const input_filepath = DES_ENCODED_OUTPUT, const char* const output_filepath = DES_DECODED_OUTPUT);
 
-		std::string _bin_xor(const std::string& bin1, const std::string& bin2);
+		// Decoded bytes [offset, offset + size) of an indexed file, only the chunks of the range are read.
+		// Range is cut at the end of the data, nothing is returned if any chunk of the range was changed
+		bool decode_range(const char* const input_filepath, uint64_t offset, size_t size, std::string& output);
+
+	private:
+		void _remove_non_ascii(std::string& source_data);
 
 		void _add_padding(std::string& str);
 		void _remove_padding(std::string& str);
 
-		std::string _permutate(const std::string& binary_str, std::vector<data_type> permutation_table);
-		void _make_cyclic_shift(std::string& binary_str, int16_t shift_size);
+		static uint64_t _bytes_to_block(const char* bytes);
+		static void _block_to_bytes(uint64_t block, char* bytes);
+
+		std::string _create_header();
+		bool _parse_header(const std::string& data);
+
+		// Parameters of the message come from the settings of the caller on encode and from the header on decode
+		void _init_message(bool is_random_iv);
+		static uint64_t _create_random_iv();
+
+		static uint64_t _permutate(uint64_t value, const permutation_lookup_type& permutation_lookup, int16_t input_size);
+		static uint32_t _make_cyclic_shift(uint32_t half_key, int16_t shift_size);
 
 		void _reset_data();
 		void _write_result(int16_t crypt_type);
 
 		void _print_init(int16_t crypt_type);
 
-		void _encrypt(int16_t crypt_type);
+		// encode() and decode() write the result only when it succeeds
+		bool _encrypt(int16_t crypt_type);
+		bool _encrypt_span(std::span<const uint8_t> input, std::span<uint8_t> output, int16_t crypt_type, DESCMAC* mac = nullptr);
+		bool _encrypt_batch(std::span<const des_record> records, int16_t crypt_type);
+		void _encrypt_data(int16_t crypt_type);
+		void _encrypt_data(const char* input, char* output, size_t blocks_count, int16_t crypt_type);
+		void _encrypt_data(const char* input, char* output, size_t blocks_count, DESCMAC& mac);
+		uint64_t _encrypt_chunks(const char* input, char* output, size_t blocks_count, int16_t crypt_type, uint64_t chaining_block);
+		uint64_t _encrypt_chunk(const char* input, char* output, size_t blocks_count, int16_t crypt_type, uint64_t chaining_block);
+		void _encrypt_blocks(uint64_t* blocks, size_t blocks_count, int16_t crypt_type);
+
+		bool _is_parallel_mode(int16_t crypt_type);
+		uint64_t _get_chaining_block(const char* input, size_t first_block);
+
+		// Mode functions return the chaining block for the next chunk.
+		// Input is the chunk the blocks were loaded from, it is not written before they return, so no scratch copy is needed
+		uint64_t _encrypt_cbc(const char* input, uint64_t* blocks, size_t blocks_count, int16_t crypt_type, uint64_t previous_block);
+		uint64_t _encrypt_cfb(const char* input, uint64_t* blocks, size_t blocks_count, int16_t crypt_type, uint64_t previous_block);
+		uint64_t _encrypt_ofb(uint64_t* blocks, size_t blocks_count, uint64_t key_stream);
+		uint64_t _encrypt_ctr(const char* input, uint64_t* blocks, size_t blocks_count, uint64_t counter);
+
+		size_t _get_threads_count();
+		ncommon::ThreadPool& _get_thread_pool();
+		void _parallel_for(size_t tasks_count, const std::function<void(size_t)>& task);
+		uint64_t _encrypt_block(uint64_t block, int16_t crypt_type);
+		static uint64_t _encrypt_block(uint64_t block, const des_stage* stages, int16_t stages_count);
+
+		// Direction is known to the compiler, so the order of the round keys costs nothing
+		template<int16_t crypt_type>
+		static void _encrypt_rounds(uint32_t& left_subblock, uint32_t& right_subblock, const uint64_t* keys_n);
+		static uint32_t _feistel(uint32_t right_subblock, uint64_t key);
+
 		void _create_sub_keys();
 
+		des_key_schedule_ptr _get_mac_key_schedule();
+
+		// Chunks of the indexed format
+		uint64_t _get_index_chunk_iv(uint64_t first_block);
+		void _encrypt_index_chunks(const char* input, char* output, size_t size, size_t chunk_size, int16_t crypt_type, uint64_t first_block);
+		uint64_t _get_index_chunk_tag(const char* data, size_t size, uint64_t chunk, bool is_last, std::string header);
+		bool _read_index(std::istream& fin, des_index& index);
+		bool _read_index_chunk(std::istream& fin, const des_index& index, uint64_t chunk, const std::string& header, std::string& data);
+
+		static constexpr sp_table_type _create_sp_table();
+
+		template<size_t output_size>
+		static constexpr permutation_lookup_type _create_permutation_lookup(const std::array<data_type, output_size>& permutation_table);
+
 	private:
 		char _padding_symbol{ '$' };
 		int16_t _padding_counter{};
 		std::string _keyword{ "keyword" };
+		bool _is_triple{};
+
+		int16_t _mode{ DES_MODE_ECB };
+		uint64_t _iv{};
+		bool _is_iv_set{};
+
+		bool _is_authenticated{};
+		bool _is_indexed{};
+
+		// Parameters of the message in work. Flag of the header of the decoded data never turns off the check asked by the caller
+		int16_t _data_mode{ DES_MODE_ECB };
+		uint64_t _data_iv{};
+		bool _is_data_indexed{};
+		bool _is_data_authenticated{};
+		uint64_t _mac_tag{};
+
+		// Chain of the mode and count of the processed blocks, kept between chunks of a stream
+		uint64_t _chaining_block{};
+		uint64_t _stream_position{};
+
+		size_t _threads_count{};
+		std::shared_ptr<ncommon::ThreadPool> _thread_pool;
 
 		std::string _source_data;	
 		std::string _result_data;
-		std::vector<std::string> _keys_n;
+
+		// Round keys and stages of the keyword, rebuilt only when the keyword changes
+		des_key_schedule_ptr _key_schedule;
+		std::shared_ptr<DESKeyScheduleCache> _key_schedule_cache;
+
+		// MAC key schedule and the schedule it was derived from
+		des_key_schedule_ptr _mac_key_schedule;
+		des_key_schedule_ptr _mac_key_source;
 
 	private:
 		// Permutation and translation tables for DES
 
 		// initial permutation IP
-		const std::vector<data_type> _initial_permutation = {
+		static constexpr std::array<data_type, 64> _initial_permutation = {
 				57, 49, 41, 33, 25, 17, 9,  1,
 				59, 51, 43, 35, 27, 19, 11, 3,
 				61, 53, 45, 37, 29, 21, 13, 5,
@@ -86,7 +303,7 @@ namespace ndes
 		};
 
 		// final permutation IP ^ -1
-		const std::vector<data_type> _final_permutation = {
+		static constexpr std::array<data_type, 64> _final_permutation = {
 				39, 7, 47, 15, 55, 23, 63, 31,
 				38, 6, 46, 14, 54, 22, 62, 30,
 				37, 5, 45, 13, 53, 21, 61, 29,
@@ -98,7 +315,7 @@ namespace ndes
 		};
 
 		// permuted choice key(56 bits key)
-		const std::vector<data_type> _permuted_choice_key1 = {
+		static constexpr std::array<data_type, 56> _permuted_choice_key1 = {
 				56, 48, 40, 32, 24, 16,  8,
 				0,  57, 49, 41, 33, 25, 17,
 				9,  1,  58, 50, 42, 34, 26,
@@ -110,7 +327,7 @@ namespace ndes
 		};
 
 		// permuted choice key(48 bits key) 
-		const std::vector<data_type> _permuted_choice_key2 = {
+		static constexpr std::array<data_type, 48> _permuted_choice_key2 = {
 				13, 16, 10, 23, 0,  4,
 				2,  27, 14, 5,  20, 9,
 				22, 18, 11, 3,  25, 7,
@@ -122,12 +339,12 @@ namespace ndes
 		};
 
 		// cyclical  shifts
-		const std::vector<data_type> _cyclical_shifts = {
+		static constexpr std::array<data_type, 16> _cyclical_shifts = {
 				1, 1, 2, 2, 2, 2, 2, 2, 1, 2, 2, 2, 2, 2, 2, 1
 		};
 
 		// Expansion table for turning 32 bit blocks into 48 bits
-		const std::vector<data_type> _expansion_table = {
+		static constexpr std::array<data_type, 48> _expansion_table = {
 				31, 0,  1,  2,  3,  4,
 				3,  4,  5,  6,  7,  8,
 				7,  8,  9,  10, 11, 12,
@@ -139,7 +356,7 @@ namespace ndes
 		};
 
 		// The(in)famous S - boxes
-		const std::vector<std::vector<data_type>> _sbox = {
+		static constexpr std::array<std::array<data_type, 64>, 8> _sbox = { {
 			// S1
 			{
 				14, 4, 13, 1, 2, 15, 11, 8, 3, 10, 6, 12, 5, 9, 0, 7,
@@ -203,10 +420,10 @@ namespace ndes
 				7, 11, 4, 1, 9, 12, 14, 2, 0, 6, 10, 13, 15, 3, 5, 8,
 				2, 1, 14, 7, 4, 10, 8, 13, 15, 12, 9, 0, 3, 5, 6, 11
 			}
-		};
+		} };
 
 		// 32 - bit permutation function P used on the output of the S - boxes
-		const std::vector<data_type> _permutation2 = {
+		static constexpr std::array<data_type, 32> _permutation2 = {
 				15, 6,  19, 20,
 				28, 11, 27, 16,
 				0,  14, 22, 25,
@@ -216,5 +433,77 @@ namespace ndes
 				18, 12, 29, 5,
 				21, 10, 3,  24
 		};
+
+		// S - boxes combined with the permutation P, indexed by the 6 bits of B[j]
+		static const sp_table_type _sp_table;
+
+		// Permutations above indexed by every byte of the input, the result is an OR of the looked up values
+		static const permutation_lookup_type _initial_permutation_lookup;
+		static const permutation_lookup_type _final_permutation_lookup;
+		static const permutation_lookup_type _permuted_choice_key1_lookup;
+		static const permutation_lookup_type _permuted_choice_key2_lookup;
+		static const permutation_lookup_type _expansion_table_lookup;
 	};
+
+
+	// Derived tables are built by the compiler, DES objects own no tables at all
+	constexpr sp_table_type DES::_create_sp_table()
+	{
+		sp_table_type sp_table{};
+
+		// Position of every bit of Bn in the output of P
+		std::array<data_type, 32> permutation2_inverse{};
+		for (int16_t i = 0; i < 32; ++i)
+			permutation2_inverse[_permutation2[i]] = static_cast<data_type>(i);
+
+		for (int16_t j = 0; j < 8; ++j)
+		{
+			for (uint32_t mini_block = 0; mini_block < 64; ++mini_block)
+			{
+				// Outer bits select the row, inner bits select the column
+				uint32_t row = ((mini_block >> 4) & 0x2) | (mini_block & 0x1);
+				uint32_t col = (mini_block >> 1) & 0xF;
+				uint32_t value = _sbox[j][row * 16 + col];
+
+				// Bits of the S - box output are bits 4j .. 4j + 3 of Bn
+				for (int16_t q = 0; q < 4; ++q)
+					if ((value >> (3 - q)) & 1)
+						sp_table[j][mini_block] |= uint32_t{ 1 } << (31 - permutation2_inverse[4 * j + q]);
+			}
+		}
+		return sp_table;
+	}
+
+	template<size_t output_size>
+	constexpr permutation_lookup_type DES::_create_permutation_lookup(const std::array<data_type, output_size>& permutation_table)
+	{
+		permutation_lookup_type permutation_lookup{};
+
+		// Output bits of every single input bit, bit 0 of the tables is the most significant bit of the value
+		std::array<uint64_t, 64> input_bits{};
+		for (size_t i = 0; i < output_size; ++i)
+			input_bits[permutation_table[i]] |= uint64_t{ 1 } << (output_size - 1 - i);
+
+		// Value of a byte is the value without its lowest bit plus that bit
+		for (int16_t byte_index = 0; byte_index < 8; ++byte_index)
+		{
+			for (uint32_t byte_value = 1; byte_value < 256; ++byte_value)
+			{
+				int16_t lowest_bit{};
+				while (!((byte_value >> lowest_bit) & 1))
+					++lowest_bit;
+
+				permutation_lookup[byte_index][byte_value] = permutation_lookup[byte_index][byte_value & (byte_value - 1)] | input_bits[8 * byte_index + 7 - lowest_bit];
+			}
+		}
+		return permutation_lookup;
+	}
+
+	inline constexpr sp_table_type DES::_sp_table = DES::_create_sp_table();
+
+	inline constexpr permutation_lookup_type DES::_initial_permutation_lookup = DES::_create_permutation_lookup(DES::_initial_permutation);
+	inline constexpr permutation_lookup_type DES::_final_permutation_lookup = DES::_create_permutation_lookup(DES::_final_permutation);
+	inline constexpr permutation_lookup_type DES::_permuted_choice_key1_lookup = DES::_create_permutation_lookup(DES::_permuted_choice_key1);
+	inline constexpr permutation_lookup_type DES::_permuted_choice_key2_lookup = DES::_create_permutation_lookup(DES::_permuted_choice_key2);
+	inline constexpr permutation_lookup_type DES::_expansion_table_lookup = DES::_create_permutation_lookup(DES::_expansion_table);
 }
\ No newline at end of file
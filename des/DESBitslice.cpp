@@ -0,0 +1,304 @@
+#include <iostream>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "DES.hpp"
+#include "DESBitslice.hpp"
+#include "DESBitsliceKernels.hpp"
+#include "DESKeySchedule.hpp"
+
+namespace
+{
+	// Asks the CPU and the OS (for the wide registers) once per kernel
+	bool cpu_supports(const std::string& kernel_name)
+	{
+		if (kernel_name == "scalar")
+			return true;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+		__builtin_cpu_init();
+
+		if (kernel_name == "sse2")
+			return __builtin_cpu_supports("sse2");
+		if (kernel_name == "avx2")
+			return __builtin_cpu_supports("avx2");
+		if (kernel_name == "avx512")
+			return __builtin_cpu_supports("avx512f");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+		int registers[4]{};
+
+		__cpuid(registers, 1);
+		if (kernel_name == "sse2")
+			return (registers[3] >> 26) & 1;
+
+		// Registers must be saved by the OS: YMM state for AVX2, also ZMM state for AVX-512
+		bool has_osxsave = (registers[2] >> 27) & 1;
+		unsigned long long enabled_state = has_osxsave ? _xgetbv(0) : 0;
+
+		__cpuidex(registers, 7, 0);
+		if (kernel_name == "avx2")
+			return ((enabled_state & 0x6) == 0x6) and ((registers[1] >> 5) & 1);
+		if (kernel_name == "avx512")
+			return ((enabled_state & 0xE6) == 0xE6) and ((registers[1] >> 16) & 1);
+#endif
+		return false;
+	}
+
+	// Pseudo random test data, the same on every run
+	uint64_t next_test_value(uint64_t& state)
+	{
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state;
+	}
+}
+
+ndes::bitslice_tables ndes::DESBitslice::_create_tables()
+{
+	bitslice_tables tables{};
+
+	std::copy(DES::_initial_permutation.begin(), DES::_initial_permutation.end(), tables.initial_permutation);
+	std::copy(DES::_final_permutation.begin(), DES::_final_permutation.end(), tables.final_permutation);
+	std::copy(DES::_expansion_table.begin(), DES::_expansion_table.end(), tables.expansion_table);
+
+	for (int16_t i = 0; i < 32; ++i)
+		tables.permutation2_inverse[DES::_permutation2[i]] = static_cast<data_type>(i);
+
+	// Follow the key bits through PC1, the shifts and PC2
+	std::array<data_type, 56> shifted_key;
+	std::copy(DES::_permuted_choice_key1.begin(), DES::_permuted_choice_key1.end(), shifted_key.begin());
+
+	for (int16_t i = 0; i < 16; ++i)
+	{
+		std::rotate(shifted_key.begin(), shifted_key.begin() + DES::_cyclical_shifts[i], shifted_key.begin() + 28);
+		std::rotate(shifted_key.begin() + 28, shifted_key.begin() + 28 + DES::_cyclical_shifts[i], shifted_key.end());
+
+		for (int16_t p = 0; p < 48; ++p)
+			tables.round_key_bits[i][p] = shifted_key[DES::_permuted_choice_key2[p]];
+	}
+	return tables;
+}
+
+size_t ndes::DESBitslice::blocks_per_pass()
+{
+	return _get_selected_kernel().load()->blocks_per_pass;
+}
+
+bool ndes::DESBitslice::is_faster()
+{
+	// Kernel is selected first, the environment variable may force it then
+	const bitslice_kernel* kernel = _get_selected_kernel().load();
+	return _get_forced_flag().load() or kernel->blocks_per_second > _get_blocks_per_second();
+}
+
+void ndes::DESBitslice::crypt_blocks(uint64_t* blocks, size_t blocks_count, const des_stage* stages, int16_t stages_count)
+{
+	_get_selected_kernel().load()->crypt_blocks(_get_tables(), blocks, blocks_count, stages, stages_count);
+}
+
+void ndes::DESBitslice::crypt_blocks(uint64_t* blocks, const uint64_t* keys, size_t blocks_count, int16_t crypt_type)
+{
+	_get_selected_kernel().load()->crypt_blocks_keys(_get_tables(), blocks, keys, blocks_count, crypt_type);
+}
+
+std::string ndes::DESBitslice::kernel_name()
+{
+	return _get_selected_kernel().load()->name;
+}
+
+std::vector<std::string> ndes::DESBitslice::kernel_names()
+{
+	std::vector<std::string> names;
+	for (const auto& kernel : _get_kernels())
+		names.push_back(kernel.name);
+	return names;
+}
+
+bool ndes::DESBitslice::set_kernel(const std::string& name)
+{
+	for (const auto& kernel : _get_kernels())
+	{
+		if (name == kernel.name)
+		{
+			_get_selected_kernel().store(&kernel);
+			_get_forced_flag().store(true);
+			return true;
+		}
+	}
+	return false;
+}
+
+const ndes::bitslice_tables& ndes::DESBitslice::_get_tables()
+{
+	static const bitslice_tables tables = _create_tables();
+	return tables;
+}
+
+const std::vector<ndes::bitslice_kernel>& ndes::DESBitslice::_get_kernels()
+{
+	static const std::vector<bitslice_kernel> kernels = _create_kernels();
+	return kernels;
+}
+
+std::vector<ndes::bitslice_kernel> ndes::DESBitslice::_create_kernels()
+{
+	std::vector<bitslice_kernel> kernels;
+
+	// Kernel which the CPU cannot run or which gives a wrong answer is never used
+	for (bitslice_kernel kernel : { get_scalar_kernel(), get_sse2_kernel(), get_avx2_kernel(), get_avx512_kernel() })
+	{
+		if (!kernel.crypt_blocks or !cpu_supports(kernel.name) or !_self_test(kernel))
+			continue;
+
+		kernel.blocks_per_second = _measure_kernel(kernel);
+		kernels.push_back(kernel);
+	}
+	return kernels;
+}
+
+std::atomic<const ndes::bitslice_kernel*>& ndes::DESBitslice::_get_selected_kernel()
+{
+	static std::atomic<const bitslice_kernel*> selected_kernel{ _select_kernel() };
+	return selected_kernel;
+}
+
+std::atomic<bool>& ndes::DESBitslice::_get_forced_flag()
+{
+	static std::atomic<bool> is_forced{};
+	return is_forced;
+}
+
+const ndes::bitslice_kernel* ndes::DESBitslice::_select_kernel()
+{
+	const auto& kernels = _get_kernels();
+
+	// Portable kernel always passes, other ones only add speed
+	const bitslice_kernel* fastest_kernel = &kernels.front();
+	for (const auto& kernel : kernels)
+		if (kernel.blocks_per_second > fastest_kernel->blocks_per_second)
+			fastest_kernel = &kernel;
+
+	// Forced kernel, e.g. for benchmarks
+	const char* forced_name = std::getenv(DES_KERNEL_ENV);
+	if (!forced_name)
+		return fastest_kernel;
+
+	for (const auto& kernel : kernels)
+	{
+		if (std::string(forced_name) == kernel.name)
+		{
+			_get_forced_flag().store(true);
+			return &kernel;
+		}
+	}
+
+	std::cout << "DES kernel [" << forced_name << "] is not available, kernel [" << fastest_kernel->name << "] is used!" << std::endl;
+	return fastest_kernel;
+}
+
+bool ndes::DESBitslice::_self_test(const bitslice_kernel& kernel)
+{
+	const bitslice_tables& tables = _get_tables();
+	size_t blocks_count = kernel.blocks_per_pass;
+
+	// Known answer of FIPS 81 / Stallings: 133457799BBCDFF1 encrypts 0123456789ABCDEF to 85E813540F0AB405
+	DESKeySchedule key_schedule(std::string("\x13\x34\x57\x79\x9B\xBC\xDF\xF1", DES_KEY_SIZE));
+	if (DES::_encrypt_block(0x0123456789ABCDEF, key_schedule.stages(DES_ENCODE), key_schedule.stages_count()) != 0x85E813540F0AB405)
+		return false;
+
+	// Every lane against the per-block path, one triple DES key for all the blocks
+	DESKeySchedule triple_key_schedule(std::string("0123456789abcdefghijklmn"));
+	std::vector<uint64_t> blocks(blocks_count), expected_blocks(blocks_count), keys(blocks_count);
+
+	uint64_t state{ 0x9E3779B97F4A7C15 };
+	for (size_t k = 0; k < blocks_count; ++k)
+	{
+		blocks[k] = next_test_value(state);
+		keys[k] = next_test_value(state);
+	}
+
+	for (int16_t crypt_type : { DES_ENCODE, DES_DECODE })
+	{
+		for (size_t k = 0; k < blocks_count; ++k)
+			expected_blocks[k] = DES::_encrypt_block(blocks[k], triple_key_schedule.stages(crypt_type), triple_key_schedule.stages_count());
+
+		std::vector<uint64_t> result_blocks(blocks);
+		kernel.crypt_blocks(tables, result_blocks.data(), blocks_count, triple_key_schedule.stages(crypt_type), triple_key_schedule.stages_count());
+
+		if (result_blocks != expected_blocks)
+			return false;
+	}
+
+	// Own key for every lane
+	for (int16_t crypt_type : { DES_ENCODE, DES_DECODE })
+	{
+		for (size_t k = 0; k < blocks_count; ++k)
+		{
+			std::string key(DES_KEY_SIZE, '\0');
+			DES::_block_to_bytes(keys[k], key.data());
+
+			DESKeySchedule block_key_schedule(key);
+			expected_blocks[k] = DES::_encrypt_block(blocks[k], block_key_schedule.stages(crypt_type), block_key_schedule.stages_count());
+		}
+
+		std::vector<uint64_t> result_blocks(blocks);
+		kernel.crypt_blocks_keys(tables, result_blocks.data(), keys.data(), blocks_count, crypt_type);
+
+		if (result_blocks != expected_blocks)
+			return false;
+	}
+	return true;
+}
+
+double ndes::DESBitslice::_measure_kernel(const bitslice_kernel& kernel)
+{
+	DESKeySchedule key_schedule(std::string("measure!"));
+	std::vector<uint64_t> blocks(DES_KERNEL_MEASURE_BLOCKS - DES_KERNEL_MEASURE_BLOCKS % kernel.blocks_per_pass);
+
+	// The best of a few runs, the first one also warms up the caches
+	double best_seconds{};
+	for (int16_t run = 0; run < 3; ++run)
+	{
+		auto start_time = std::chrono::steady_clock::now();
+		kernel.crypt_blocks(_get_tables(), blocks.data(), blocks.size(), key_schedule.stages(DES_ENCODE), key_schedule.stages_count());
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+		if (run == 0 or seconds < best_seconds)
+			best_seconds = seconds;
+	}
+	return blocks.size() / std::max(best_seconds, 1e-9);
+}
+
+double ndes::DESBitslice::_get_blocks_per_second()
+{
+	static const double blocks_per_second = _measure_blocks();
+	return blocks_per_second;
+}
+
+double ndes::DESBitslice::_measure_blocks()
+{
+	DESKeySchedule key_schedule(std::string("measure!"));
+	std::vector<uint64_t> blocks(DES_KERNEL_MEASURE_BLOCKS);
+
+	double best_seconds{};
+	for (int16_t run = 0; run < 3; ++run)
+	{
+		auto start_time = std::chrono::steady_clock::now();
+		for (auto& block : blocks)
+			block = DES::_encrypt_block(block, key_schedule.stages(DES_ENCODE), key_schedule.stages_count());
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+		if (run == 0 or seconds < best_seconds)
+			best_seconds = seconds;
+	}
+	return blocks.size() / std::max(best_seconds, 1e-9);
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace ndes
+{
+	// Minimal count of blocks when DES switches from the per-block path to the bitsliced one
+	constexpr size_t DES_BITSLICE_MIN_BLOCKS = 1024;
+
+	// Environment variable to force a kernel: scalar, sse2, avx2 or avx512
+	const char* const DES_KERNEL_ENV = "DES_KERNEL";
+
+	// Blocks encrypted by every kernel to compare their speed
+	constexpr size_t DES_KERNEL_MEASURE_BLOCKS = 4096;
+
+
+	struct bitslice_tables;
+	struct bitslice_kernel;
+	struct des_stage;
+
+
+	// Bitsliced DES: every bit position of the blocks lives in its own machine word,
+	// so one pass encrypts as many blocks as there are bits in the word.
+	// Kernels for every instruction set are in one binary: on the first use the CPU is probed,
+	// every kernel it can run is checked with known answers and the fastest one is selected.
+	class DESBitslice
+	{
+	public:
+		// 64 for uint64_t words, 128 for SSE2, 256 for AVX2 and 512 for AVX-512
+		static size_t blocks_per_pass();
+
+		// Selected kernel encrypts more blocks per second than the per-block path on this CPU,
+		// or it was forced by DES_KERNEL or set_kernel(), then it is used without the comparison
+		static bool is_faster();
+
+		// Blocks are DES blocks with bit 0 in the most significant bit, blocks_count must be a multiple of blocks_per_pass()
+		static void crypt_blocks(uint64_t* blocks, size_t blocks_count, const des_stage* stages, int16_t stages_count);
+
+		// Single DES where every block has its own 64 bits key, keys[i] goes with blocks[i]
+		static void crypt_blocks(uint64_t* blocks, const uint64_t* keys, size_t blocks_count, int16_t crypt_type);
+
+		// Selected kernel and all kernels which passed the self test on this CPU
+		static std::string kernel_name();
+		static std::vector<std::string> kernel_names();
+
+		// Forces a kernel of kernel_names(), not to be called while other threads encrypt
+		static bool set_kernel(const std::string& name);
+
+	private:
+		static const bitslice_tables& _get_tables();
+		static bitslice_tables _create_tables();
+
+		static const std::vector<bitslice_kernel>& _get_kernels();
+		static std::vector<bitslice_kernel> _create_kernels();
+
+		static std::atomic<const bitslice_kernel*>& _get_selected_kernel();
+		static std::atomic<bool>& _get_forced_flag();
+		static const bitslice_kernel* _select_kernel();
+
+		static bool _self_test(const bitslice_kernel& kernel);
+		static double _measure_kernel(const bitslice_kernel& kernel);
+
+		// Speed of DES::_encrypt_block, measured once like the kernels
+		static double _get_blocks_per_second();
+		static double _measure_blocks();
+	};
+}
@@ -0,0 +1,67 @@
+#include "DES.hpp"
+#include "DESBitsliceKernels.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define DES_BITSLICE_AVX2_KERNEL
+
+#include <immintrin.h>
+
+// Only this unit is built for AVX2, the dispatcher calls it on CPUs which have it
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+#include "DESBitsliceImpl.hpp"
+
+namespace
+{
+	// 256 blocks in one pass
+	struct avx2_word
+	{
+		using type = __m256i;
+		static constexpr size_t lanes = 4;
+
+		static __m256i zero() { return _mm256_setzero_si256(); }
+		static __m256i ones() { return _mm256_set1_epi64x(-1); }
+
+		static __m256i broadcast(uint64_t value) { return _mm256_set1_epi64x(static_cast<long long>(value)); }
+		static __m256i load(const uint64_t* src) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src)); }
+		static void store(uint64_t* dst, __m256i word) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), word); }
+
+		static __m256i bit_and(__m256i word1, __m256i word2) { return _mm256_and_si256(word1, word2); }
+		static __m256i bit_or(__m256i word1, __m256i word2) { return _mm256_or_si256(word1, word2); }
+		static __m256i bit_xor(__m256i word1, __m256i word2) { return _mm256_xor_si256(word1, word2); }
+		// word1 and not word2
+		static __m256i bit_andnot(__m256i word1, __m256i word2) { return _mm256_andnot_si256(word2, word1); }
+		static __m256i bit_not(__m256i word) { return _mm256_xor_si256(word, ones()); }
+	};
+
+	void crypt_blocks_avx2(const ndes::bitslice_tables& tables, uint64_t* blocks, size_t blocks_count, const ndes::des_stage* stages, int16_t stages_count)
+	{
+		crypt_blocks<avx2_word>(tables, blocks, blocks_count, stages, stages_count);
+	}
+
+	void crypt_blocks_keys_avx2(const ndes::bitslice_tables& tables, uint64_t* blocks, const uint64_t* keys, size_t blocks_count, int16_t crypt_type)
+	{
+		crypt_blocks_keys<avx2_word>(tables, blocks, keys, blocks_count, crypt_type);
+	}
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+#endif
+
+ndes::bitslice_kernel ndes::get_avx2_kernel()
+{
+#if defined(DES_BITSLICE_AVX2_KERNEL)
+	return { "avx2", 256, crypt_blocks_avx2, crypt_blocks_keys_avx2, 0 };
+#else
+	return { "avx2", 256, nullptr, nullptr, 0 };
+#endif
+}
@@ -0,0 +1,68 @@
+#include "DES.hpp"
+#include "DESBitsliceKernels.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define DES_BITSLICE_AVX512_KERNEL
+
+#include <immintrin.h>
+
+// Only this unit is built for AVX-512, the dispatcher calls it on CPUs which have it
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#endif
+
+#include "DESBitsliceImpl.hpp"
+
+namespace
+{
+	// 512 blocks in one pass
+	struct avx512_word
+	{
+		using type = __m512i;
+		static constexpr size_t lanes = 8;
+
+		static __m512i zero() { return _mm512_setzero_si512(); }
+		static __m512i ones() { return _mm512_set1_epi64(-1); }
+
+		static __m512i broadcast(uint64_t value) { return _mm512_set1_epi64(static_cast<long long>(value)); }
+		static __m512i load(const uint64_t* src) { return _mm512_loadu_si512(src); }
+		static void store(uint64_t* dst, __m512i word) { _mm512_storeu_si512(dst, word); }
+
+		static __m512i bit_and(__m512i word1, __m512i word2) { return _mm512_and_si512(word1, word2); }
+		static __m512i bit_or(__m512i word1, __m512i word2) { return _mm512_or_si512(word1, word2); }
+		static __m512i bit_xor(__m512i word1, __m512i word2) { return _mm512_xor_si512(word1, word2); }
+		// word1 and not word2 as one ternary logic instruction, 0x30 is the table of a and not b.
+		// _mm512_andnot_si512 of GCC passes an uninitialised vector to its builtin, which gives -Wmaybe-uninitialized in every S-box
+		static __m512i bit_andnot(__m512i word1, __m512i word2) { return _mm512_ternarylogic_epi64(word1, word2, word2, 0x30); }
+		static __m512i bit_not(__m512i word) { return _mm512_xor_si512(word, ones()); }
+	};
+
+	void crypt_blocks_avx512(const ndes::bitslice_tables& tables, uint64_t* blocks, size_t blocks_count, const ndes::des_stage* stages, int16_t stages_count)
+	{
+		crypt_blocks<avx512_word>(tables, blocks, blocks_count, stages, stages_count);
+	}
+
+	void crypt_blocks_keys_avx512(const ndes::bitslice_tables& tables, uint64_t* blocks, const uint64_t* keys, size_t blocks_count, int16_t crypt_type)
+	{
+		crypt_blocks_keys<avx512_word>(tables, blocks, keys, blocks_count, crypt_type);
+	}
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+#endif
+
+ndes::bitslice_kernel ndes::get_avx512_kernel()
+{
+#if defined(DES_BITSLICE_AVX512_KERNEL)
+	return { "avx512", 512, crypt_blocks_avx512, crypt_blocks_keys_avx512, 0 };
+#else
+	return { "avx512", 512, nullptr, nullptr, 0 };
+#endif
+}
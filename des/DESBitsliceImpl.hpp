@@ -0,0 +1,199 @@
+#pragma once
+
+// Gate networks of the bitsliced DES, generic over the word type.
+// Included only by the kernel translation units, after they switch to their instruction set:
+// everything is in an anonymous namespace and uses no library templates,
+// so every kernel gets its own copy of the code built for its own instructions.
+// DES.hpp must be included before the switch, it has the DES constants and stages.
+
+#include "DESBitsliceKernels.hpp"
+#include "DESBitsliceSboxes.hpp"
+
+namespace
+{
+	void transpose64(uint64_t* rows)
+	{
+		// Swap off-diagonal submatrices of halving size, row r bit c moves to row c bit r
+		uint64_t mask = 0x00000000FFFFFFFF;
+
+		for (int16_t j = 32; j != 0; j >>= 1, mask ^= mask << j)
+		{
+			for (int16_t k = 0; k < 64; ++k)
+			{
+				if (k & j)
+					continue;
+
+				uint64_t temp = ((rows[k] >> j) ^ rows[k + j]) & mask;
+				rows[k + j] ^= temp;
+				rows[k] ^= temp << j;
+			}
+		}
+	}
+
+	// Turns every 64 blocks into 64 bit planes, DES bit i is the bit (63 - i) of the block
+	template<size_t lanes>
+	void blocks_to_planes(const uint64_t* blocks, uint64_t (*plane_lanes)[lanes])
+	{
+		uint64_t rows[64];
+
+		for (size_t l = 0; l < lanes; ++l)
+		{
+			for (int16_t i = 0; i < 64; ++i)
+				rows[i] = blocks[64 * l + i];
+
+			transpose64(rows);
+
+			for (int16_t i = 0; i < 64; ++i)
+				plane_lanes[i][l] = rows[63 - i];
+		}
+	}
+
+	template<size_t lanes>
+	void planes_to_blocks(uint64_t (*plane_lanes)[lanes], uint64_t* blocks)
+	{
+		uint64_t rows[64];
+
+		for (size_t l = 0; l < lanes; ++l)
+		{
+			for (int16_t i = 0; i < 64; ++i)
+				rows[63 - i] = plane_lanes[i][l];
+
+			transpose64(rows);
+
+			for (int16_t i = 0; i < 64; ++i)
+				blocks[64 * l + i] = rows[i];
+		}
+	}
+
+	template<typename word, typename Word = typename word::type>
+	void sbox_gates(int16_t sbox_index, const Word* x, Word* out)
+	{
+		switch (sbox_index)
+		{
+		case 0: sbox1<word>(x, out); break;
+		case 1: sbox2<word>(x, out); break;
+		case 2: sbox3<word>(x, out); break;
+		case 3: sbox4<word>(x, out); break;
+		case 4: sbox5<word>(x, out); break;
+		case 5: sbox6<word>(x, out); break;
+		case 6: sbox7<word>(x, out); break;
+		default: sbox8<word>(x, out); break;
+		}
+	}
+
+	// round_key_bit(stage, round, bit) gives the word to xor with the bit of the expanded block
+	template<typename word, typename round_key_source>
+	void crypt_pass(const ndes::bitslice_tables& tables, uint64_t* blocks, const ndes::des_stage* stages, int16_t stages_count, const round_key_source& round_key_bit)
+	{
+		using Word = typename word::type;
+
+		uint64_t plane_lanes[64][word::lanes];
+		blocks_to_planes(blocks, plane_lanes);
+
+		// Initial permutation is just a choice of the planes
+		Word halves[2][32];
+		Word* left_subblock = halves[0];
+		Word* right_subblock = halves[1];
+		Word* temp_subblock{};
+
+		for (int16_t k = 0; k < 32; ++k)
+		{
+			left_subblock[k] = word::load(plane_lanes[tables.initial_permutation[k]]);
+			right_subblock[k] = word::load(plane_lanes[tables.initial_permutation[32 + k]]);
+		}
+
+		for (int16_t s = 0; s < stages_count; ++s)
+		{
+			// Final permutation of one stage and initial permutation of the next one cancel out
+			if (s != 0)
+			{
+				temp_subblock = left_subblock;
+				left_subblock = right_subblock;
+				right_subblock = temp_subblock;
+			}
+
+			int16_t iteration{ 0 }, iteration_adjustment{ 1 };
+			if (stages[s].crypt_type == ndes::DES_DECODE)
+			{
+				iteration = 15;
+				iteration_adjustment = -1;
+			}
+
+			for (int16_t i = 0; i < 16; ++i, iteration += iteration_adjustment)
+			{
+				for (int16_t j = 0; j < 8; ++j)
+				{
+					Word x[6], out[4];
+
+					// Expansion and xor with the round key
+					for (int16_t b = 0; b < 6; ++b)
+						x[b] = word::bit_xor(right_subblock[tables.expansion_table[6 * j + b]], round_key_bit(s, iteration, 6 * j + b));
+
+					sbox_gates<word>(j, x, out);
+
+					// Permutation P and xor with L[i - 1], which becomes R[i]
+					for (int16_t q = 0; q < 4; ++q)
+					{
+						Word& target = left_subblock[tables.permutation2_inverse[4 * j + q]];
+						target = word::bit_xor(target, out[q]);
+					}
+				}
+
+				temp_subblock = left_subblock;
+				left_subblock = right_subblock;
+				right_subblock = temp_subblock;
+			}
+		}
+
+		// Final permutation of R[16]L[16]
+		for (int16_t i = 0; i < 64; ++i)
+		{
+			uint8_t position = tables.final_permutation[i];
+			word::store(plane_lanes[i], (position < 32) ? right_subblock[position] : left_subblock[position - 32]);
+		}
+
+		planes_to_blocks(plane_lanes, blocks);
+	}
+
+	template<typename word>
+	void crypt_blocks(const ndes::bitslice_tables& tables, uint64_t* blocks, size_t blocks_count, const ndes::des_stage* stages, int16_t stages_count)
+	{
+		constexpr size_t pass_size = 64 * word::lanes;
+
+		// Every block has the same key, so every bit of a round key is a plane of all zeros or all ones made by the schedule
+		auto round_key_bit = [stages](int16_t stage, int16_t iteration, int16_t bit)
+			{
+				return word::broadcast(stages[stage].key_planes[48 * iteration + bit]);
+			};
+
+		for (size_t k = 0; k + pass_size <= blocks_count; k += pass_size)
+			crypt_pass<word>(tables, blocks + k, stages, stages_count, round_key_bit);
+	}
+
+	template<typename word>
+	void crypt_blocks_keys(const ndes::bitslice_tables& tables, uint64_t* blocks, const uint64_t* keys, size_t blocks_count, int16_t crypt_type)
+	{
+		using Word = typename word::type;
+		constexpr size_t pass_size = 64 * word::lanes;
+
+		const ndes::des_stage stage{ nullptr, crypt_type, nullptr };
+
+		for (size_t k = 0; k + pass_size <= blocks_count; k += pass_size)
+		{
+			// Keys are sliced like the blocks, then round key bits are just some of the key planes
+			uint64_t key_plane_lanes[64][word::lanes];
+			blocks_to_planes(keys + k, key_plane_lanes);
+
+			Word key_planes[64];
+			for (int16_t i = 0; i < 64; ++i)
+				key_planes[i] = word::load(key_plane_lanes[i]);
+
+			auto round_key_bit = [&tables, &key_planes](int16_t, int16_t iteration, int16_t bit)
+				{
+					return key_planes[tables.round_key_bits[iteration][bit]];
+				};
+
+			crypt_pass<word>(tables, blocks + k, &stage, 1, round_key_bit);
+		}
+	}
+}
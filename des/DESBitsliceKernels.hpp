@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// Internal header of the bitsliced DES: tables and kernels for every instruction set.
+// Every kernel lives in its own translation unit built for its instruction set,
+// so nothing here may have inline code, which the linker could share between them.
+
+namespace ndes
+{
+	struct des_stage;
+
+
+	// Tables of the gate networks, derived from the DES tables
+	struct bitslice_tables
+	{
+		uint8_t initial_permutation[64];
+		uint8_t final_permutation[64];
+		uint8_t expansion_table[48];
+
+		// Position in the P output of every bit of Bn
+		uint8_t permutation2_inverse[32];
+
+		// Bit of the 64 bits key behind every bit of every round key, the key schedule is only a choice of bits
+		uint8_t round_key_bits[16][48];
+	};
+
+
+	// Whole passes of blocks with the keys of the stages
+	using bitslice_crypt_type = void (*)(const bitslice_tables& tables, uint64_t* blocks, size_t blocks_count, const des_stage* stages, int16_t stages_count);
+
+	// Whole passes of single DES blocks, keys[i] goes with blocks[i]
+	using bitslice_crypt_keys_type = void (*)(const bitslice_tables& tables, uint64_t* blocks, const uint64_t* keys, size_t blocks_count, int16_t crypt_type);
+
+	struct bitslice_kernel
+	{
+		const char* name;
+		size_t blocks_per_pass;
+
+		// nullptr when the compiler or the target cannot build the kernel
+		bitslice_crypt_type crypt_blocks;
+		bitslice_crypt_keys_type crypt_blocks_keys;
+
+		// Measured by the dispatcher on this CPU
+		double blocks_per_second;
+	};
+
+
+	bitslice_kernel get_scalar_kernel();
+	bitslice_kernel get_sse2_kernel();
+	bitslice_kernel get_avx2_kernel();
+	bitslice_kernel get_avx512_kernel();
+}
@@ -0,0 +1,67 @@
+#include "DES.hpp"
+#include "DESBitsliceKernels.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define DES_BITSLICE_SSE2_KERNEL
+
+#include <immintrin.h>
+
+// Only this unit is built for SSE2, the dispatcher calls it on CPUs which have it
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+#include "DESBitsliceImpl.hpp"
+
+namespace
+{
+	// 128 blocks in one pass
+	struct sse2_word
+	{
+		using type = __m128i;
+		static constexpr size_t lanes = 2;
+
+		static __m128i zero() { return _mm_setzero_si128(); }
+		static __m128i ones() { return _mm_set1_epi32(-1); }
+
+		static __m128i broadcast(uint64_t value) { return _mm_set1_epi64x(static_cast<long long>(value)); }
+		static __m128i load(const uint64_t* src) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)); }
+		static void store(uint64_t* dst, __m128i word) { _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), word); }
+
+		static __m128i bit_and(__m128i word1, __m128i word2) { return _mm_and_si128(word1, word2); }
+		static __m128i bit_or(__m128i word1, __m128i word2) { return _mm_or_si128(word1, word2); }
+		static __m128i bit_xor(__m128i word1, __m128i word2) { return _mm_xor_si128(word1, word2); }
+		// word1 and not word2
+		static __m128i bit_andnot(__m128i word1, __m128i word2) { return _mm_andnot_si128(word2, word1); }
+		static __m128i bit_not(__m128i word) { return _mm_xor_si128(word, ones()); }
+	};
+
+	void crypt_blocks_sse2(const ndes::bitslice_tables& tables, uint64_t* blocks, size_t blocks_count, const ndes::des_stage* stages, int16_t stages_count)
+	{
+		crypt_blocks<sse2_word>(tables, blocks, blocks_count, stages, stages_count);
+	}
+
+	void crypt_blocks_keys_sse2(const ndes::bitslice_tables& tables, uint64_t* blocks, const uint64_t* keys, size_t blocks_count, int16_t crypt_type)
+	{
+		crypt_blocks_keys<sse2_word>(tables, blocks, keys, blocks_count, crypt_type);
+	}
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+#endif
+
+ndes::bitslice_kernel ndes::get_sse2_kernel()
+{
+#if defined(DES_BITSLICE_SSE2_KERNEL)
+	return { "sse2", 128, crypt_blocks_sse2, crypt_blocks_keys_sse2, 0 };
+#else
+	return { "sse2", 128, nullptr, nullptr, 0 };
+#endif
+}
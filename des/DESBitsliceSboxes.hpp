@@ -0,0 +1,552 @@
+#pragma once
+
+// Gate circuits of the S-boxes for the bitsliced DES, generic over the word type.
+// Circuits were searched the way M. Kwan did it ("Reducing the Gate Count of Bitslice DES"): an output is split
+// by one input into two halves, each half only has to be right where that input has its value, so the rest of it
+// is free, and the halves are split again until one gate over the gates found before gives them.
+// Gates of one output are used by the next ones. S-box input bit 0 is the first bit of the 6 bits, output 0 is the highest bit.
+// Included only by DESBitsliceImpl.hpp, see it for the rules of the kernel headers.
+
+namespace
+{
+	// S1, 62 gates
+	template<typename word, typename Word = typename word::type>
+	void sbox1(const Word* in, Word* out)
+	{
+		Word x1 = word::bit_xor(in[1], in[2]);
+		Word x2 = word::bit_xor(in[0], in[3]);
+		Word x3 = word::bit_andnot(x2, in[5]);
+		Word x4 = word::bit_xor(x1, x3);
+		Word x5 = word::bit_or(in[3], x1);
+		Word x6 = word::bit_and(x5, in[5]);
+		Word x7 = word::bit_xor(x4, x6);
+		Word x8 = word::bit_and(x7, in[0]);
+		Word x9 = word::bit_xor(x2, x8);
+		Word x10 = word::bit_andnot(x9, in[4]);
+		Word x11 = word::bit_xor(x4, x10);
+		Word x12 = word::bit_xor(in[5], x2);
+		Word x13 = word::bit_not(x11);
+		Word x14 = word::bit_andnot(x13, in[4]);
+		Word x15 = word::bit_xor(x12, x14);
+		Word x16 = word::bit_xor(in[4], x11);
+		Word x17 = word::bit_and(x16, in[3]);
+		Word x18 = word::bit_xor(x6, x17);
+		Word x19 = word::bit_and(x18, in[2]);
+		Word x20 = word::bit_xor(x15, x19);
+		Word x21 = word::bit_andnot(x20, in[1]);
+		Word x22 = word::bit_xor(x11, x21);
+		Word x23 = word::bit_andnot(in[5], in[0]);
+		Word x24 = word::bit_andnot(x23, in[3]);
+		Word x25 = word::bit_xor(x11, x24);
+		Word x26 = word::bit_or(x11, x23);
+		Word x27 = word::bit_and(x26, in[2]);
+		Word x28 = word::bit_xor(x12, x27);
+		Word x29 = word::bit_andnot(x28, in[4]);
+		Word x30 = word::bit_xor(x25, x29);
+		Word x31 = word::bit_xor(in[4], x9);
+		Word x32 = word::bit_andnot(x31, in[3]);
+		Word x33 = word::bit_xor(x14, x32);
+		Word x34 = word::bit_or(x10, x12);
+		Word x35 = word::bit_and(x34, in[5]);
+		Word x36 = word::bit_xor(x33, x35);
+		Word x37 = word::bit_and(x36, in[1]);
+		Word x38 = word::bit_xor(x30, x37);
+		Word x39 = word::bit_andnot(x15, x29);
+		Word x40 = word::bit_xor(in[4], x30);
+		Word x41 = word::bit_andnot(x40, in[1]);
+		Word x42 = word::bit_xor(x39, x41);
+		Word x43 = word::bit_and(x20, x34);
+		Word x44 = word::bit_xor(x5, x9);
+		Word x45 = word::bit_and(x5, in[1]);
+		Word x46 = word::bit_xor(x44, x45);
+		Word x47 = word::bit_and(x46, in[4]);
+		Word x48 = word::bit_xor(x43, x47);
+		Word x49 = word::bit_andnot(x48, in[5]);
+		Word x50 = word::bit_xor(x42, x49);
+		Word x51 = word::bit_xor(x16, x44);
+		Word x52 = word::bit_and(x35, in[5]);
+		Word x53 = word::bit_xor(x51, x52);
+		Word x54 = word::bit_xor(x13, x46);
+		Word x55 = word::bit_andnot(x54, in[2]);
+		Word x56 = word::bit_xor(x53, x55);
+		Word x57 = word::bit_xor(x30, x50);
+		Word x58 = word::bit_xor(x5, x32);
+		Word x59 = word::bit_andnot(x58, in[2]);
+		Word x60 = word::bit_xor(x57, x59);
+		Word x61 = word::bit_and(x60, in[0]);
+		Word x62 = word::bit_xor(x56, x61);
+
+		out[0] = x62;
+		out[1] = x50;
+		out[2] = x22;
+		out[3] = x38;
+	}
+
+	// S2, 55 gates
+	template<typename word, typename Word = typename word::type>
+	void sbox2(const Word* in, Word* out)
+	{
+		Word x1 = word::bit_xor(in[1], in[5]);
+		Word x2 = word::bit_not(in[0]);
+		Word x3 = word::bit_or(in[0], in[5]);
+		Word x4 = word::bit_andnot(x3, in[1]);
+		Word x5 = word::bit_xor(x2, x4);
+		Word x6 = word::bit_andnot(x5, in[2]);
+		Word x7 = word::bit_xor(x1, x6);
+		Word x8 = word::bit_or(in[1], x2);
+		Word x9 = word::bit_and(x3, in[2]);
+		Word x10 = word::bit_andnot(x8, x9);
+		Word x11 = word::bit_andnot(x10, in[3]);
+		Word x12 = word::bit_xor(x7, x11);
+		Word x13 = word::bit_or(in[5], x10);
+		Word x14 = word::bit_or(in[0], x7);
+		Word x15 = word::bit_andnot(x14, in[3]);
+		Word x16 = word::bit_xor(x13, x15);
+		Word x17 = word::bit_andnot(x11, in[1]);
+		Word x18 = word::bit_xor(x16, x17);
+		Word x19 = word::bit_andnot(x18, in[4]);
+		Word x20 = word::bit_xor(x12, x19);
+		Word x21 = word::bit_xor(in[3], x2);
+		Word x22 = word::bit_andnot(x1, in[2]);
+		Word x23 = word::bit_xor(x21, x22);
+		Word x24 = word::bit_andnot(in[3], in[5]);
+		Word x25 = word::bit_and(x24, in[1]);
+		Word x26 = word::bit_xor(x23, x25);
+		Word x27 = word::bit_xor(x3, x16);
+		Word x28 = word::bit_and(x13, in[2]);
+		Word x29 = word::bit_or(x27, x28);
+		Word x30 = word::bit_andnot(x15, in[1]);
+		Word x31 = word::bit_or(x29, x30);
+		Word x32 = word::bit_and(x31, in[4]);
+		Word x33 = word::bit_xor(x26, x32);
+		Word x34 = word::bit_xor(x7, x23);
+		Word x35 = word::bit_or(in[1], x21);
+		Word x36 = word::bit_andnot(x35, in[4]);
+		Word x37 = word::bit_xor(x34, x36);
+		Word x38 = word::bit_andnot(x35, in[5]);
+		Word x39 = word::bit_or(in[2], x7);
+		Word x40 = word::bit_andnot(x39, in[4]);
+		Word x41 = word::bit_or(x38, x40);
+		Word x42 = word::bit_and(x41, in[0]);
+		Word x43 = word::bit_xor(x37, x42);
+		Word x44 = word::bit_xor(in[1], x26);
+		Word x45 = word::bit_andnot(x8, x43);
+		Word x46 = word::bit_andnot(x45, in[4]);
+		Word x47 = word::bit_xor(x44, x46);
+		Word x48 = word::bit_or(x21, x30);
+		Word x49 = word::bit_andnot(in[1], in[2]);
+		Word x50 = word::bit_xor(x48, x49);
+		Word x51 = word::bit_or(x11, x43);
+		Word x52 = word::bit_andnot(x51, in[4]);
+		Word x53 = word::bit_andnot(x50, x52);
+		Word x54 = word::bit_and(x53, in[5]);
+		Word x55 = word::bit_xor(x47, x54);
+
+		out[0] = x43;
+		out[1] = x33;
+		out[2] = x20;
+		out[3] = x55;
+	}
+
+	// S3, 56 gates
+	template<typename word, typename Word = typename word::type>
+	void sbox3(const Word* in, Word* out)
+	{
+		Word x1 = word::bit_xor(in[0], in[5]);
+		Word x2 = word::bit_and(in[3], in[5]);
+		Word x3 = word::bit_xor(in[2], x2);
+		Word x4 = word::bit_andnot(x3, in[1]);
+		Word x5 = word::bit_xor(x1, x4);
+		Word x6 = word::bit_xor(in[3], x3);
+		Word x7 = word::bit_and(x6, in[4]);
+		Word x8 = word::bit_xor(x5, x7);
+		Word x9 = word::bit_and(x3, in[4]);
+		Word x10 = word::bit_xor(in[1], x9);
+		Word x11 = word::bit_or(in[4], in[5]);
+		Word x12 = word::bit_andnot(x11, in[0]);
+		Word x13 = word::bit_andnot(x10, x12);
+		Word x14 = word::bit_andnot(in[1], in[0]);
+		Word x15 = word::bit_andnot(x14, in[3]);
+		Word x16 = word::bit_xor(x13, x15);
+		Word x17 = word::bit_andnot(x16, in[2]);
+		Word x18 = word::bit_xor(x8, x17);
+		Word x19 = word::bit_xor(in[4], x14);
+		Word x20 = word::bit_not(x18);
+		Word x21 = word::bit_andnot(x20, in[5]);
+		Word x22 = word::bit_xor(x19, x21);
+		Word x23 = word::bit_and(x20, x22);
+		Word x24 = word::bit_and(in[3], in[1]);
+		Word x25 = word::bit_xor(x23, x24);
+		Word x26 = word::bit_and(x25, in[3]);
+		Word x27 = word::bit_xor(x22, x26);
+		Word x28 = word::bit_or(x1, x3);
+		Word x29 = word::bit_andnot(x16, in[5]);
+		Word x30 = word::bit_xor(x28, x29);
+		Word x31 = word::bit_and(x30, in[2]);
+		Word x32 = word::bit_xor(x27, x31);
+		Word x33 = word::bit_xor(in[3], in[4]);
+		Word x34 = word::bit_or(in[3], x8);
+		Word x35 = word::bit_andnot(x34, in[0]);
+		Word x36 = word::bit_xor(x33, x35);
+		Word x37 = word::bit_xor(in[2], x15);
+		Word x38 = word::bit_and(x37, in[1]);
+		Word x39 = word::bit_xor(x36, x38);
+		Word x40 = word::bit_or(x30, x38);
+		Word x41 = word::bit_or(in[1], x20);
+		Word x42 = word::bit_andnot(x41, in[2]);
+		Word x43 = word::bit_or(x40, x42);
+		Word x44 = word::bit_andnot(x43, in[5]);
+		Word x45 = word::bit_xor(x39, x44);
+		Word x46 = word::bit_xor(x9, x12);
+		Word x47 = word::bit_or(x20, x39);
+		Word x48 = word::bit_andnot(x47, in[3]);
+		Word x49 = word::bit_xor(x46, x48);
+		Word x50 = word::bit_or(in[0], in[3]);
+		Word x51 = word::bit_and(x6, in[0]);
+		Word x52 = word::bit_xor(x48, x51);
+		Word x53 = word::bit_andnot(x52, in[4]);
+		Word x54 = word::bit_xor(x50, x53);
+		Word x55 = word::bit_andnot(x54, in[1]);
+		Word x56 = word::bit_xor(x49, x55);
+
+		out[0] = x45;
+		out[1] = x18;
+		out[2] = x32;
+		out[3] = x56;
+	}
+
+	// S4, 46 gates
+	template<typename word, typename Word = typename word::type>
+	void sbox4(const Word* in, Word* out)
+	{
+		Word x1 = word::bit_or(in[0], in[2]);
+		Word x2 = word::bit_and(x1, in[4]);
+		Word x3 = word::bit_xor(in[0], x2);
+		Word x4 = word::bit_not(in[2]);
+		Word x5 = word::bit_andnot(x4, in[1]);
+		Word x6 = word::bit_xor(x3, x5);
+		Word x7 = word::bit_and(in[0], in[4]);
+		Word x8 = word::bit_xor(x1, x7);
+		Word x9 = word::bit_and(x8, in[1]);
+		Word x10 = word::bit_xor(in[4], x9);
+		Word x11 = word::bit_and(x10, in[3]);
+		Word x12 = word::bit_xor(x6, x11);
+		Word x13 = word::bit_xor(x2, x4);
+		Word x14 = word::bit_and(x13, in[1]);
+		Word x15 = word::bit_xor(x8, x14);
+		Word x16 = word::bit_andnot(x13, x3);
+		Word x17 = word::bit_xor(in[2], in[4]);
+		Word x18 = word::bit_andnot(x17, in[1]);
+		Word x19 = word::bit_xor(x16, x18);
+		Word x20 = word::bit_andnot(x19, in[3]);
+		Word x21 = word::bit_xor(x15, x20);
+		Word x22 = word::bit_andnot(x21, in[5]);
+		Word x23 = word::bit_xor(x12, x22);
+		Word x24 = word::bit_andnot(x10, x13);
+		Word x25 = word::bit_and(x24, in[0]);
+		Word x26 = word::bit_xor(x6, x25);
+		Word x27 = word::bit_xor(x3, x10);
+		Word x28 = word::bit_andnot(x27, in[3]);
+		Word x29 = word::bit_xor(x26, x28);
+		Word x30 = word::bit_xor(in[1], x23);
+		Word x31 = word::bit_xor(x6, x16);
+		Word x32 = word::bit_andnot(x31, in[1]);
+		Word x33 = word::bit_xor(x30, x32);
+		Word x34 = word::bit_xor(in[1], x31);
+		Word x35 = word::bit_and(x14, in[0]);
+		Word x36 = word::bit_xor(x34, x35);
+		Word x37 = word::bit_and(x36, in[3]);
+		Word x38 = word::bit_xor(x33, x37);
+		Word x39 = word::bit_andnot(x38, in[5]);
+		Word x40 = word::bit_xor(x29, x39);
+		Word x41 = word::bit_xor(in[5], x21);
+		Word x42 = word::bit_and(x41, in[5]);
+		Word x43 = word::bit_xor(x12, x42);
+		Word x44 = word::bit_xor(x38, x41);
+		Word x45 = word::bit_and(x44, in[5]);
+		Word x46 = word::bit_xor(x29, x45);
+
+		out[0] = x23;
+		out[1] = x43;
+		out[2] = x46;
+		out[3] = x40;
+	}
+
+	// S5, 62 gates
+	template<typename word, typename Word = typename word::type>
+	void sbox5(const Word* in, Word* out)
+	{
+		Word x1 = word::bit_xor(in[2], in[5]);
+		Word x2 = word::bit_andnot(in[1], in[4]);
+		Word x3 = word::bit_or(x1, x2);
+		Word x4 = word::bit_andnot(in[4], in[1]);
+		Word x5 = word::bit_xor(x3, x4);
+		Word x6 = word::bit_or(in[5], x2);
+		Word x7 = word::bit_and(x6, in[3]);
+		Word x8 = word::bit_xor(x5, x7);
+		Word x9 = word::bit_andnot(x8, in[4]);
+		Word x10 = word::bit_andnot(x9, in[1]);
+		Word x11 = word::bit_xor(x1, x10);
+		Word x12 = word::bit_or(in[1], in[4]);
+		Word x13 = word::bit_not(x5);
+		Word x14 = word::bit_andnot(x13, in[3]);
+		Word x15 = word::bit_xor(x12, x14);
+		Word x16 = word::bit_andnot(x15, in[5]);
+		Word x17 = word::bit_or(x11, x16);
+		Word x18 = word::bit_andnot(x17, in[0]);
+		Word x19 = word::bit_xor(x8, x18);
+		Word x20 = word::bit_xor(x5, x11);
+		Word x21 = word::bit_or(in[1], x16);
+		Word x22 = word::bit_and(x21, in[3]);
+		Word x23 = word::bit_xor(x20, x22);
+		Word x24 = word::bit_and(in[4], x21);
+		Word x25 = word::bit_and(x7, in[3]);
+		Word x26 = word::bit_xor(x24, x25);
+		Word x27 = word::bit_and(x26, in[0]);
+		Word x28 = word::bit_xor(x23, x27);
+		Word x29 = word::bit_xor(in[4], x3);
+		Word x30 = word::bit_and(x1, in[3]);
+		Word x31 = word::bit_andnot(x29, x30);
+		Word x32 = word::bit_andnot(x5, x7);
+		Word x33 = word::bit_and(x32, in[0]);
+		Word x34 = word::bit_xor(x31, x33);
+		Word x35 = word::bit_and(x34, in[2]);
+		Word x36 = word::bit_xor(x28, x35);
+		Word x37 = word::bit_xor(in[4], x28);
+		Word x38 = word::bit_andnot(x13, in[0]);
+		Word x39 = word::bit_xor(x37, x38);
+		Word x40 = word::bit_andnot(x37, in[0]);
+		Word x41 = word::bit_andnot(x40, in[1]);
+		Word x42 = word::bit_xor(x39, x41);
+		Word x43 = word::bit_xor(x16, x28);
+		Word x44 = word::bit_xor(in[0], x37);
+		Word x45 = word::bit_and(x44, in[5]);
+		Word x46 = word::bit_xor(x34, x45);
+		Word x47 = word::bit_andnot(x46, in[2]);
+		Word x48 = word::bit_xor(x43, x47);
+		Word x49 = word::bit_andnot(x48, in[3]);
+		Word x50 = word::bit_xor(x42, x49);
+		Word x51 = word::bit_xor(in[0], x29);
+		Word x52 = word::bit_xor(x2, x50);
+		Word x53 = word::bit_and(x52, in[0]);
+		Word x54 = word::bit_xor(x36, x53);
+		Word x55 = word::bit_andnot(x54, in[2]);
+		Word x56 = word::bit_xor(x51, x55);
+		Word x57 = word::bit_or(in[5], x36);
+		Word x58 = word::bit_and(x5, x28);
+		Word x59 = word::bit_andnot(x58, in[1]);
+		Word x60 = word::bit_xor(x57, x59);
+		Word x61 = word::bit_and(x60, in[3]);
+		Word x62 = word::bit_xor(x56, x61);
+
+		out[0] = x36;
+		out[1] = x50;
+		out[2] = x19;
+		out[3] = x62;
+	}
+
+	// S6, 60 gates
+	template<typename word, typename Word = typename word::type>
+	void sbox6(const Word* in, Word* out)
+	{
+		Word x1 = word::bit_xor(in[3], in[5]);
+		Word x2 = word::bit_xor(in[1], in[5]);
+		Word x3 = word::bit_and(x2, in[0]);
+		Word x4 = word::bit_xor(x1, x3);
+		Word x5 = word::bit_and(in[1], in[5]);
+		Word x6 = word::bit_xor(in[0], x5);
+		Word x7 = word::bit_or(in[0], x2);
+		Word x8 = word::bit_and(x7, in[3]);
+		Word x9 = word::bit_or(x6, x8);
+		Word x10 = word::bit_and(x9, in[4]);
+		Word x11 = word::bit_xor(x4, x10);
+		Word x12 = word::bit_xor(in[5], x7);
+		Word x13 = word::bit_and(in[0], in[4]);
+		Word x14 = word::bit_xor(x12, x13);
+		Word x15 = word::bit_andnot(in[4], in[1]);
+		Word x16 = word::bit_or(x14, x15);
+		Word x17 = word::bit_and(x16, in[2]);
+		Word x18 = word::bit_xor(x11, x17);
+		Word x19 = word::bit_xor(x4, x14);
+		Word x20 = word::bit_andnot(x12, in[1]);
+		Word x21 = word::bit_andnot(x19, x20);
+		Word x22 = word::bit_not(x20);
+		Word x23 = word::bit_andnot(x22, in[4]);
+		Word x24 = word::bit_xor(x13, x23);
+		Word x25 = word::bit_andnot(x24, in[2]);
+		Word x26 = word::bit_xor(x21, x25);
+		Word x27 = word::bit_or(in[0], x18);
+		Word x28 = word::bit_and(x27, in[4]);
+		Word x29 = word::bit_xor(x16, x28);
+		Word x30 = word::bit_and(in[1], x25);
+		Word x31 = word::bit_and(x30, in[5]);
+		Word x32 = word::bit_or(x29, x31);
+		Word x33 = word::bit_and(x32, in[3]);
+		Word x34 = word::bit_xor(x26, x33);
+		Word x35 = word::bit_xor(in[0], x19);
+		Word x36 = word::bit_and(in[1], x27);
+		Word x37 = word::bit_and(x36, in[2]);
+		Word x38 = word::bit_xor(x35, x37);
+		Word x39 = word::bit_or(in[1], x26);
+		Word x40 = word::bit_andnot(x9, in[0]);
+		Word x41 = word::bit_xor(x39, x40);
+		Word x42 = word::bit_xor(in[2], x27);
+		Word x43 = word::bit_andnot(x42, in[3]);
+		Word x44 = word::bit_xor(x3, x43);
+		Word x45 = word::bit_andnot(x44, in[5]);
+		Word x46 = word::bit_xor(x41, x45);
+		Word x47 = word::bit_andnot(x46, in[4]);
+		Word x48 = word::bit_xor(x38, x47);
+		Word x49 = word::bit_or(x14, x25);
+		Word x50 = word::bit_and(x49, in[0]);
+		Word x51 = word::bit_xor(in[4], x50);
+		Word x52 = word::bit_or(in[2], x3);
+		Word x53 = word::bit_andnot(x52, in[1]);
+		Word x54 = word::bit_xor(x51, x53);
+		Word x55 = word::bit_xor(in[3], x48);
+		Word x56 = word::bit_xor(x16, x55);
+		Word x57 = word::bit_and(x56, in[5]);
+		Word x58 = word::bit_xor(x55, x57);
+		Word x59 = word::bit_and(x58, in[3]);
+		Word x60 = word::bit_xor(x54, x59);
+
+		out[0] = x48;
+		out[1] = x34;
+		out[2] = x18;
+		out[3] = x60;
+	}
+
+	// S7, 57 gates
+	template<typename word, typename Word = typename word::type>
+	void sbox7(const Word* in, Word* out)
+	{
+		Word x1 = word::bit_xor(in[1], in[3]);
+		Word x2 = word::bit_andnot(in[2], in[5]);
+		Word x3 = word::bit_xor(x1, x2);
+		Word x4 = word::bit_or(in[3], in[5]);
+		Word x5 = word::bit_xor(in[2], in[3]);
+		Word x6 = word::bit_andnot(x5, in[1]);
+		Word x7 = word::bit_xor(x4, x6);
+		Word x8 = word::bit_and(x7, in[4]);
+		Word x9 = word::bit_xor(x3, x8);
+		Word x10 = word::bit_or(in[4], x7);
+		Word x11 = word::bit_andnot(in[1], in[2]);
+		Word x12 = word::bit_xor(x10, x11);
+		Word x13 = word::bit_or(x6, x8);
+		Word x14 = word::bit_andnot(x7, in[2]);
+		Word x15 = word::bit_or(x13, x14);
+		Word x16 = word::bit_andnot(x15, in[5]);
+		Word x17 = word::bit_xor(x12, x16);
+		Word x18 = word::bit_andnot(x17, in[0]);
+		Word x19 = word::bit_xor(x9, x18);
+		Word x20 = word::bit_xor(x3, x12);
+		Word x21 = word::bit_and(x20, in[4]);
+		Word x22 = word::bit_xor(x9, x21);
+		Word x23 = word::bit_and(x10, in[0]);
+		Word x24 = word::bit_xor(x22, x23);
+		Word x25 = word::bit_and(in[2], x19);
+		Word x26 = word::bit_xor(in[0], x12);
+		Word x27 = word::bit_andnot(in[4], x20);
+		Word x28 = word::bit_andnot(x27, in[0]);
+		Word x29 = word::bit_xor(x26, x28);
+		Word x30 = word::bit_and(x29, in[3]);
+		Word x31 = word::bit_xor(x25, x30);
+		Word x32 = word::bit_and(x31, in[5]);
+		Word x33 = word::bit_xor(x24, x32);
+		Word x34 = word::bit_xor(in[1], x29);
+		Word x35 = word::bit_xor(x9, x32);
+		Word x36 = word::bit_andnot(x35, in[2]);
+		Word x37 = word::bit_xor(x34, x36);
+		Word x38 = word::bit_xor(x2, x16);
+		Word x39 = word::bit_andnot(x38, in[1]);
+		Word x40 = word::bit_xor(x37, x39);
+		Word x41 = word::bit_or(x8, x32);
+		Word x42 = word::bit_and(x41, in[1]);
+		Word x43 = word::bit_or(x27, x42);
+		Word x44 = word::bit_and(x43, in[0]);
+		Word x45 = word::bit_xor(x40, x44);
+		Word x46 = word::bit_xor(x17, x19);
+		Word x47 = word::bit_not(x7);
+		Word x48 = word::bit_and(x47, in[0]);
+		Word x49 = word::bit_xor(x47, x48);
+		Word x50 = word::bit_andnot(x49, in[4]);
+		Word x51 = word::bit_xor(x46, x50);
+		Word x52 = word::bit_xor(in[1], x30);
+		Word x53 = word::bit_and(x20, x34);
+		Word x54 = word::bit_andnot(x53, in[2]);
+		Word x55 = word::bit_xor(x52, x54);
+		Word x56 = word::bit_and(x55, in[5]);
+		Word x57 = word::bit_xor(x51, x56);
+
+		out[0] = x19;
+		out[1] = x57;
+		out[2] = x33;
+		out[3] = x45;
+	}
+
+	// S8, 55 gates
+	template<typename word, typename Word = typename word::type>
+	void sbox8(const Word* in, Word* out)
+	{
+		Word x1 = word::bit_xor(in[1], in[2]);
+		Word x2 = word::bit_xor(in[0], in[2]);
+		Word x3 = word::bit_andnot(in[0], in[1]);
+		Word x4 = word::bit_andnot(x2, x3);
+		Word x5 = word::bit_and(x4, in[4]);
+		Word x6 = word::bit_xor(x1, x5);
+		Word x7 = word::bit_or(in[0], in[4]);
+		Word x8 = word::bit_andnot(x7, in[3]);
+		Word x9 = word::bit_xor(x6, x8);
+		Word x10 = word::bit_andnot(in[0], x5);
+		Word x11 = word::bit_and(in[1], x2);
+		Word x12 = word::bit_or(in[0], in[1]);
+		Word x13 = word::bit_andnot(x12, in[4]);
+		Word x14 = word::bit_xor(x11, x13);
+		Word x15 = word::bit_andnot(x14, in[3]);
+		Word x16 = word::bit_xor(x10, x15);
+		Word x17 = word::bit_and(x16, in[5]);
+		Word x18 = word::bit_xor(x9, x17);
+		Word x19 = word::bit_xor(in[3], x13);
+		Word x20 = word::bit_or(x7, x19);
+		Word x21 = word::bit_and(x20, in[1]);
+		Word x22 = word::bit_xor(x19, x21);
+		Word x23 = word::bit_xor(in[4], x12);
+		Word x24 = word::bit_andnot(x23, in[2]);
+		Word x25 = word::bit_xor(x22, x24);
+		Word x26 = word::bit_not(in[0]);
+		Word x27 = word::bit_xor(x14, x25);
+		Word x28 = word::bit_andnot(x6, in[3]);
+		Word x29 = word::bit_or(x27, x28);
+		Word x30 = word::bit_and(x29, in[0]);
+		Word x31 = word::bit_xor(x26, x30);
+		Word x32 = word::bit_andnot(x31, in[5]);
+		Word x33 = word::bit_xor(x25, x32);
+		Word x34 = word::bit_and(x25, in[1]);
+		Word x35 = word::bit_xor(x2, x34);
+		Word x36 = word::bit_xor(x25, x26);
+		Word x37 = word::bit_and(x21, in[1]);
+		Word x38 = word::bit_xor(x36, x37);
+		Word x39 = word::bit_andnot(x38, in[4]);
+		Word x40 = word::bit_xor(x35, x39);
+		Word x41 = word::bit_xor(in[1], x15);
+		Word x42 = word::bit_andnot(x27, in[0]);
+		Word x43 = word::bit_xor(x41, x42);
+		Word x44 = word::bit_andnot(x27, x23);
+		Word x45 = word::bit_and(x44, in[2]);
+		Word x46 = word::bit_xor(x43, x45);
+		Word x47 = word::bit_and(x46, in[5]);
+		Word x48 = word::bit_xor(x40, x47);
+		Word x49 = word::bit_xor(in[5], x40);
+		Word x50 = word::bit_xor(x30, x46);
+		Word x51 = word::bit_andnot(x23, x36);
+		Word x52 = word::bit_andnot(x51, in[3]);
+		Word x53 = word::bit_xor(x50, x52);
+		Word x54 = word::bit_andnot(x53, in[5]);
+		Word x55 = word::bit_xor(x49, x54);
+
+		out[0] = x55;
+		out[1] = x33;
+		out[2] = x18;
+		out[3] = x48;
+	}
+}
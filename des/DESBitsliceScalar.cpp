@@ -0,0 +1,32 @@
+#include "DES.hpp"
+#include "DESBitsliceKernels.hpp"
+#include "DESBitsliceImpl.hpp"
+
+namespace
+{
+	// 64 blocks in one pass, works on any CPU
+	struct scalar_word
+	{
+		using type = uint64_t;
+		static constexpr size_t lanes = 1;
+
+		static uint64_t zero() { return 0; }
+		static uint64_t ones() { return ~uint64_t{}; }
+
+		static uint64_t broadcast(uint64_t value) { return value; }
+		static uint64_t load(const uint64_t* src) { return *src; }
+		static void store(uint64_t* dst, uint64_t word) { *dst = word; }
+
+		static uint64_t bit_and(uint64_t word1, uint64_t word2) { return word1 & word2; }
+		static uint64_t bit_or(uint64_t word1, uint64_t word2) { return word1 | word2; }
+		static uint64_t bit_xor(uint64_t word1, uint64_t word2) { return word1 ^ word2; }
+		// word1 and not word2
+		static uint64_t bit_andnot(uint64_t word1, uint64_t word2) { return word1 & ~word2; }
+		static uint64_t bit_not(uint64_t word) { return ~word; }
+	};
+}
+
+ndes::bitslice_kernel ndes::get_scalar_kernel()
+{
+	return { "scalar", 64 * scalar_word::lanes, crypt_blocks<scalar_word>, crypt_blocks_keys<scalar_word>, 0 };
+}
@@ -0,0 +1,76 @@
+#include <algorithm>
+
+#include "DESCMAC.hpp"
+#include "DESKeySchedule.hpp"
+
+ndes::DESCMAC::DESCMAC(des_key_schedule_ptr key_schedule)
+	: _key_schedule(std::move(key_schedule))
+{
+	// Subkeys are doublings of the encrypted zero block
+	_subkey1 = _double_subkey(_encrypt_block(0));
+	_subkey2 = _double_subkey(_subkey1);
+}
+
+void ndes::DESCMAC::update(const char* data, size_t size)
+{
+	while (size)
+	{
+		// Held block is not the last one, since more data came
+		if (_last_block_size == 8)
+		{
+			_state = _encrypt_block(_state ^ DES::_bytes_to_block(_last_block));
+			_last_block_size = 0;
+		}
+
+		// Whole blocks go straight from the data, except the one which may be the last
+		if (_last_block_size == 0)
+		{
+			for (; size > 8; data += 8, size -= 8)
+				_state = _encrypt_block(_state ^ DES::_bytes_to_block(data));
+		}
+
+		size_t copy_size = std::min(8 - _last_block_size, size);
+		std::copy(data, data + copy_size, _last_block + _last_block_size);
+
+		_last_block_size += copy_size;
+		data += copy_size;
+		size -= copy_size;
+	}
+}
+
+uint64_t ndes::DESCMAC::finish()
+{
+	uint64_t last_block{};
+
+	if (_last_block_size == 8)
+		last_block = DES::_bytes_to_block(_last_block) ^ _subkey1;
+	else
+	{
+		// Padding is a single one bit and zeros
+		char padded_block[8]{};
+		std::copy(_last_block, _last_block + _last_block_size, padded_block);
+		padded_block[_last_block_size] = static_cast<char>(0x80);
+
+		last_block = DES::_bytes_to_block(padded_block) ^ _subkey2;
+	}
+
+	uint64_t tag = _encrypt_block(_state ^ last_block);
+	reset();
+	return tag;
+}
+
+void ndes::DESCMAC::reset()
+{
+	_state = 0;
+	_last_block_size = 0;
+}
+
+uint64_t ndes::DESCMAC::_double_subkey(uint64_t subkey)
+{
+	return (subkey << 1) ^ ((subkey >> 63) ? DES_MAC_RB : 0);
+}
+
+uint64_t ndes::DESCMAC::_encrypt_block(uint64_t block) const
+{
+	return DES::_encrypt_block(block, _key_schedule->stages(DES_ENCODE), _key_schedule->stages_count());
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "DES.hpp"
+
+namespace ndes
+{
+	// Size of the authentication tag after the encoded data
+	constexpr size_t DES_MAC_SIZE = 8;
+
+	// Reduction constant of the doubling in GF(2^64)
+	constexpr uint64_t DES_MAC_RB = 0x1B;
+
+
+	// CMAC (NIST SP 800-38B) with DES or triple DES as the block cipher.
+	// Data may come in pieces of any size, the last block is held back until finish()
+	class DESCMAC
+	{
+	public:
+		explicit DESCMAC(des_key_schedule_ptr key_schedule);
+
+		void update(const char* data, size_t size);
+
+		// Tag of all the data since the creation or the last reset()
+		uint64_t finish();
+		void reset();
+
+	private:
+		static uint64_t _double_subkey(uint64_t subkey);
+
+		uint64_t _encrypt_block(uint64_t block) const;
+
+	private:
+		des_key_schedule_ptr _key_schedule;
+
+		// K1 for a whole last block, K2 for a padded one
+		uint64_t _subkey1{};
+		uint64_t _subkey2{};
+
+		uint64_t _state{};
+		char _last_block[8]{};
+		size_t _last_block_size{};
+	};
+}
@@ -0,0 +1,99 @@
+#include "DESKeySchedule.hpp"
+
+ndes::DESKeySchedule::DESKeySchedule(const std::string& key)
+{
+	// Other sizes are DES keys, padded by zeros or cut to 8 bytes
+	bool is_triple = (key.size() == DES_TRIPLE_KEY2_SIZE or key.size() == DES_TRIPLE_KEY3_SIZE);
+
+	_key = is_triple ? key : key.substr(0, DES_KEY_SIZE);
+	_key.resize(is_triple ? key.size() : DES_KEY_SIZE, '\0');
+
+	// Two keys triple DES uses K1 as K3
+	int16_t keys_count = is_triple ? 3 : 1;
+	int16_t keywords_count = static_cast<int16_t>(_key.size() / DES_KEY_SIZE);
+
+	for (int16_t k = 0; k < keys_count; ++k)
+	{
+		uint64_t temp_key = DES::_permutate(DES::_bytes_to_block(_key.data() + DES_KEY_SIZE * (k % keywords_count)), DES::_permuted_choice_key1_lookup, 64);
+
+		uint32_t left_subkey = static_cast<uint32_t>(temp_key >> (DES_KEY_BINSIZE / 2)) & 0x0FFFFFFF;
+		uint32_t right_subkey = static_cast<uint32_t>(temp_key) & 0x0FFFFFFF;
+
+		for (int16_t i = 0; i < 16; ++i)
+		{
+			left_subkey = DES::_make_cyclic_shift(left_subkey, DES::_cyclical_shifts[i]);
+			right_subkey = DES::_make_cyclic_shift(right_subkey, DES::_cyclical_shifts[i]);
+
+			uint64_t joined_subkey = (static_cast<uint64_t>(left_subkey) << (DES_KEY_BINSIZE / 2)) | right_subkey;
+			_keys_n[16 * k + i] = DES::_permutate(joined_subkey, DES::_permuted_choice_key2_lookup, DES_KEY_BINSIZE);
+
+			for (int16_t p = 0; p < 48; ++p)
+				_key_planes[48 * (16 * k + i) + p] = ((_keys_n[16 * k + i] >> (47 - p)) & 1) ? ~uint64_t{} : 0;
+		}
+	}
+
+	for (int16_t crypt_type : { DES_ENCODE, DES_DECODE })
+	{
+		des_stage* stages = _stages[crypt_type];
+
+		if (!is_triple)
+		{
+			stages[0] = { _keys_n.data(), crypt_type, _key_planes.data() };
+			continue;
+		}
+
+		// Triple DES encodes as E(K1) D(K2) E(K3) and decodes as D(K3) E(K2) D(K1)
+		int16_t inverse_type = (crypt_type == DES_ENCODE) ? DES_DECODE : DES_ENCODE;
+		size_t first_key = (crypt_type == DES_ENCODE) ? 0 : 2;
+
+		stages[0] = { _keys_n.data() + 16 * first_key, crypt_type, _key_planes.data() + 48 * 16 * first_key };
+		stages[1] = { _keys_n.data() + 16, inverse_type, _key_planes.data() + 48 * 16 };
+		stages[2] = { _keys_n.data() + 16 * (2 - first_key), crypt_type, _key_planes.data() + 48 * 16 * (2 - first_key) };
+	}
+	_stages_count = keys_count;
+}
+
+ndes::des_key_schedule_ptr ndes::DESKeyScheduleCache::get(const std::string& key)
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		auto iterator = _entries_index.find(key);
+		if (iterator != _entries_index.end())
+		{
+			// Move to the front as the most recently used
+			_entries.splice(_entries.begin(), _entries, iterator->second);
+			return iterator->second->second;
+		}
+	}
+
+	// Schedule is built without the lock, other threads can use the cache meanwhile
+	auto key_schedule = std::make_shared<const DESKeySchedule>(key);
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_capacity == 0 or _entries_index.count(key))
+		return key_schedule;
+
+	_entries.emplace_front(key, key_schedule);
+	_entries_index[key] = _entries.begin();
+
+	if (_entries.size() > _capacity)
+	{
+		_entries_index.erase(_entries.back().first);
+		_entries.pop_back();
+	}
+	return key_schedule;
+}
+
+size_t ndes::DESKeyScheduleCache::size()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _entries.size();
+}
+
+void ndes::DESKeyScheduleCache::clear()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_entries.clear();
+	_entries_index.clear();
+}
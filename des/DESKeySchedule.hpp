@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include <array>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "DES.hpp"
+
+namespace ndes
+{
+	constexpr size_t DES_KEY_SCHEDULE_CACHE_SIZE = 64;
+
+
+	// Round keys of a DES or triple DES key, they do not change after the creation,
+	// so one schedule can be used by many threads and DES objects in both directions
+	class DESKeySchedule
+	{
+	public:
+		// 8 bytes key for DES, 16 and 24 bytes keys for two and three keys triple DES
+		explicit DESKeySchedule(const std::string& key);
+
+		// Stages point to the own round keys
+		DESKeySchedule(const DESKeySchedule&) = delete;
+		DESKeySchedule& operator=(const DESKeySchedule&) = delete;
+
+		const std::string& key() const { return _key; }
+		bool is_triple() const { return _stages_count == 3; }
+
+		const des_stage* stages(int16_t crypt_type) const { return _stages[crypt_type]; }
+		int16_t stages_count() const { return _stages_count; }
+
+	private:
+		std::string _key;
+
+		// 48 bits round keys, stored in the low bits, 16 for every key of the triple DES
+		std::array<uint64_t, 48> _keys_n{};
+
+		// Every bit of the round keys for the bitsliced kernels, made once with the schedule
+		std::array<uint64_t, 48 * 48> _key_planes{};
+
+		// Stages of a block for both directions
+		des_stage _stages[2][3]{};
+		int16_t _stages_count{};
+	};
+
+
+	// Bounded cache of the schedules by the key bytes, the least recently used schedule goes out first
+	class DESKeyScheduleCache
+	{
+	public:
+		explicit DESKeyScheduleCache(size_t capacity = DES_KEY_SCHEDULE_CACHE_SIZE) : _capacity(capacity) {}
+
+		// Safe to call from many threads
+		des_key_schedule_ptr get(const std::string& key);
+
+		size_t size();
+		void clear();
+
+	private:
+		using entry_type = std::pair<std::string, des_key_schedule_ptr>;
+
+		size_t _capacity;
+
+		std::mutex _mutex;
+		std::list<entry_type> _entries;
+		std::unordered_map<std::string, std::list<entry_type>::iterator> _entries_index;
+	};
+}
@@ -0,0 +1,256 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+#include "DES.hpp"
+#include "DESBitslice.hpp"
+#include "DESKeySchedule.hpp"
+#include "DESKeySearch.hpp"
+
+void ndes::DESKeySearch::set_known_block(uint64_t plaintext_block, uint64_t ciphertext_block)
+{
+	_plaintext_block = plaintext_block;
+	_ciphertext_block = ciphertext_block;
+}
+
+bool ndes::DESKeySearch::set_keyspace(const std::string& charset, const std::string& prefix, size_t keyword_length)
+{
+	if (charset.empty() or keyword_length == 0 or prefix.size() > keyword_length)
+	{
+		std::cout << "Invalid keyspace: charset must not be empty and prefix must not be longer than the keyword!\n" << std::endl;
+		return false;
+	}
+
+	// Symbols after the 8th one are cut off by set_keyword()
+	size_t fixed_positions = std::min<size_t>(prefix.size(), DES_KEY_SIZE);
+	size_t free_positions = std::min<size_t>(keyword_length, DES_KEY_SIZE) - fixed_positions;
+
+	uint64_t keyspace_size{ 1 };
+	for (size_t p = 0; p < free_positions; ++p)
+	{
+		if (keyspace_size > std::numeric_limits<uint64_t>::max() / charset.size())
+		{
+			std::cout << "Keyspace is too large, it must have less than 2^64 keys!\n" << std::endl;
+			return false;
+		}
+		keyspace_size *= charset.size();
+	}
+
+	_charset = charset;
+	_prefix = prefix;
+	_keyword_length = keyword_length;
+	_free_positions = free_positions;
+	_keyspace_size = keyspace_size;
+
+	// The key is made by DES itself, so the padding of short keywords is exactly the one of set_keyword()
+	DES des;
+	des.set_keyword(prefix + std::string(keyword_length - prefix.size(), charset[0]));
+	std::string key = des.get_key_schedule()->key();
+
+	_base_key = 0;
+	for (size_t p = 0; p < DES_KEY_SIZE; ++p)
+		if (p < fixed_positions or p >= fixed_positions + free_positions)
+			_base_key |= static_cast<uint64_t>(static_cast<uint8_t>(key[p])) << (56 - 8 * p);
+
+	return true;
+}
+
+std::string ndes::DESKeySearch::get_keyword(uint64_t index) const
+{
+	std::string keyword = _prefix + std::string(_keyword_length - _prefix.size(), _charset[0]);
+
+	// The last free position changes fastest
+	for (size_t p = _prefix.size() + _free_positions; p-- > _prefix.size();)
+	{
+		keyword[p] = _charset[index % _charset.size()];
+		index /= _charset.size();
+	}
+	return keyword;
+}
+
+std::vector<ndes::des_keyspace_range> ndes::DESKeySearch::split_keyspace(size_t ranges_count) const
+{
+	std::vector<des_keyspace_range> ranges;
+	ranges_count = std::max<size_t>(ranges_count, 1);
+
+	uint64_t range_size = _keyspace_size / ranges_count;
+	uint64_t remainder = _keyspace_size % ranges_count;
+
+	// First ranges take one more candidate each, until the remainder is spread
+	for (uint64_t k = 0, first = 0; k < ranges_count and first < _keyspace_size; ++k)
+	{
+		uint64_t count = range_size + (k < remainder ? 1 : 0);
+		ranges.push_back({ first, count });
+		first += count;
+	}
+	return ranges;
+}
+
+std::vector<std::string> ndes::DESKeySearch::search(des_keyspace_range range, const char* const checkpoint_filepath)
+{
+	std::vector<std::string> keywords;
+	std::vector<uint64_t> found;
+
+	if (range.first >= _keyspace_size)
+		return keywords;
+
+	range.count = std::min(range.count, _keyspace_size - range.first);
+	uint64_t last = range.first + range.count;
+	uint64_t next = range.first;
+
+	if (checkpoint_filepath)
+	{
+		next = _load_checkpoint(checkpoint_filepath, range, found);
+		if (next != range.first)
+			std::cout << "Resuming search from candidate [" << next << "]." << std::endl;
+	}
+
+	size_t threads_count = _threads_count ? _threads_count : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	if (!_thread_pool or _thread_pool->size() != threads_count)
+		_thread_pool = std::make_shared<ncommon::ThreadPool>(threads_count);
+
+	std::cout << "Start searching keys [" << next << ", " << last << ") of [" << _keyspace_size << "] using [" << threads_count << "] thread(-s).\n" << std::endl;
+
+	auto start_time = std::chrono::steady_clock::now();
+	auto report_time = start_time;
+	uint64_t start = next;
+
+	while (next < last)
+	{
+		uint64_t round_size = std::min(DES_KEY_SEARCH_ROUND, last - next);
+		_search_candidates(next, round_size, found);
+		next += round_size;
+
+		if (checkpoint_filepath)
+			_save_checkpoint(checkpoint_filepath, range, next, found);
+
+		auto now = std::chrono::steady_clock::now();
+		if (now - report_time >= std::chrono::seconds(1) or next == last)
+		{
+			double seconds = std::chrono::duration<double>(now - start_time).count();
+			std::cout << "Checked [" << next - range.first << "] of [" << range.count << "] keys, ["
+				<< static_cast<uint64_t>((next - start) / std::max(seconds, 1e-9)) << "] keys/s, found [" << found.size() << "]." << std::endl;
+			report_time = now;
+		}
+	}
+
+	std::sort(found.begin(), found.end());
+	found.erase(std::unique(found.begin(), found.end()), found.end());
+
+	for (uint64_t index : found)
+		keywords.push_back(get_keyword(index));
+	return keywords;
+}
+
+uint64_t ndes::DESKeySearch::_get_key(uint64_t index) const
+{
+	uint64_t key = _base_key;
+	size_t fixed_positions = std::min<size_t>(_prefix.size(), DES_KEY_SIZE);
+
+	for (size_t p = fixed_positions + _free_positions; p-- > fixed_positions;)
+	{
+		key |= static_cast<uint64_t>(static_cast<uint8_t>(_charset[index % _charset.size()])) << (56 - 8 * p);
+		index /= _charset.size();
+	}
+	return key;
+}
+
+void ndes::DESKeySearch::_search_candidates(uint64_t first, uint64_t count, std::vector<uint64_t>& found)
+{
+	std::mutex found_mutex;
+	size_t tasks_count = static_cast<size_t>((count + DES_CHUNK_BLOCKS - 1) / DES_CHUNK_BLOCKS);
+
+	_thread_pool->parallel_for(tasks_count, [this, first, count, &found, &found_mutex](size_t task)
+		{
+			uint64_t task_first = first + task * DES_CHUNK_BLOCKS;
+			size_t candidates_count = static_cast<size_t>(std::min<uint64_t>(DES_CHUNK_BLOCKS, first + count - task_first));
+
+			// Last pass is filled up with the last candidate
+			size_t passes_size = DESBitslice::blocks_per_pass();
+			size_t blocks_count = (candidates_count + passes_size - 1) / passes_size * passes_size;
+
+			uint64_t blocks[DES_CHUNK_BLOCKS];
+			uint64_t keys[DES_CHUNK_BLOCKS];
+
+			for (size_t k = 0; k < blocks_count; ++k)
+			{
+				blocks[k] = _plaintext_block;
+				keys[k] = _get_key(task_first + std::min(k, candidates_count - 1));
+			}
+
+			DESBitslice::crypt_blocks(blocks, keys, blocks_count, DES_ENCODE);
+
+			for (size_t k = 0; k < candidates_count; ++k)
+			{
+				if (blocks[k] == _ciphertext_block)
+				{
+					std::lock_guard<std::mutex> lock(found_mutex);
+					found.push_back(task_first + k);
+				}
+			}
+		}
+	);
+}
+
+uint64_t ndes::DESKeySearch::_load_checkpoint(const char* const checkpoint_filepath, des_keyspace_range range, std::vector<uint64_t>& found)
+{
+	std::ifstream fin(checkpoint_filepath);
+	std::string parameters;
+	uint64_t first{}, count{}, next{};
+
+	// A checkpoint of another search or another range is not used
+	if (!std::getline(fin, parameters) or parameters != _get_checkpoint_parameters())
+		return range.first;
+
+	if (!(fin >> first >> count >> next) or first != range.first or count != range.count or next < first or next > first + count)
+		return range.first;
+
+	for (uint64_t index{}; fin >> index;)
+		found.push_back(index);
+	return next;
+}
+
+void ndes::DESKeySearch::_save_checkpoint(const char* const checkpoint_filepath, des_keyspace_range range, uint64_t next, const std::vector<uint64_t>& found)
+{
+	// Parameters of the search, range, position to resume from and the keys found so far.
+	// New checkpoint is written aside and renamed over the old one, so a crash leaves one of them whole
+	std::string temporary_filepath = std::string(checkpoint_filepath) + ".tmp";
+	std::ofstream fout(temporary_filepath, std::ios::trunc);
+	fout << _get_checkpoint_parameters() << '\n';
+	fout << range.first << ' ' << range.count << ' ' << next;
+
+	for (uint64_t index : found)
+		fout << ' ' << index;
+	fout << '\n';
+	fout.close();
+
+	std::error_code error;
+	if (fout)
+		std::filesystem::rename(temporary_filepath, checkpoint_filepath, error);
+
+	if (!fout or error)
+		std::cout << "Cannot write checkpoint file [" << checkpoint_filepath << "]!\n" << std::endl;
+}
+
+std::string ndes::DESKeySearch::_get_checkpoint_parameters() const
+{
+	// Charset and prefix may have any symbols, so they are written in hex
+	auto to_hex = [](const std::string& data)
+		{
+			std::ostringstream hex;
+			for (auto symbol : data)
+				hex << std::hex << (static_cast<uint8_t>(symbol) >> 4) << (static_cast<uint8_t>(symbol) & 0x0F);
+			return hex.str();
+		};
+
+	std::ostringstream parameters;
+	parameters << std::hex << _plaintext_block << ' ' << _ciphertext_block << ' ' << std::dec << _keyword_length << ' ' << to_hex(_charset) << ' ' << to_hex(_prefix);
+	return parameters.str();
+}
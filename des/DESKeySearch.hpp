@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../common/ThreadPool.hpp"
+
+namespace ndes
+{
+	// Candidates tested between two progress reports and checkpoints
+	constexpr uint64_t DES_KEY_SEARCH_ROUND = 1 << 22;
+
+	// Part of the keyspace: candidates [first, first + count)
+	struct des_keyspace_range
+	{
+		uint64_t first;
+		uint64_t count;
+	};
+
+
+	// Known plaintext attack on the keywords of DES::set_keyword(): every keyword is a fixed prefix
+	// and symbols of a charset, short keywords are padded the same way as set_keyword() does it
+	class DESKeySearch
+	{
+	public:
+		// One block of the plaintext and its ciphertext in ECB mode, bytes in the big-endian order
+		void set_known_block(uint64_t plaintext_block, uint64_t ciphertext_block);
+
+		// Keywords of the given length, only the first 8 symbols make the key
+		bool set_keyspace(const std::string& charset, const std::string& prefix, size_t keyword_length);
+
+		// 0 threads means one thread per core
+		void set_threads_count(size_t threads_count) { _threads_count = threads_count; }
+
+		uint64_t keyspace_size() const { return _keyspace_size; }
+		std::string get_keyword(uint64_t index) const;
+
+		// Independent ranges for separate runs or machines
+		std::vector<des_keyspace_range> split_keyspace(size_t ranges_count) const;
+
+		// Returns the keywords which give the ciphertext, the checkpoint file keeps the position to resume from
+		std::vector<std::string> search(des_keyspace_range range, const char* const checkpoint_filepath = nullptr);
+
+	private:
+		uint64_t _get_key(uint64_t index) const;
+		void _search_candidates(uint64_t first, uint64_t count, std::vector<uint64_t>& found);
+
+		uint64_t _load_checkpoint(const char* const checkpoint_filepath, des_keyspace_range range, std::vector<uint64_t>& found);
+		void _save_checkpoint(const char* const checkpoint_filepath, des_keyspace_range range, uint64_t next, const std::vector<uint64_t>& found);
+
+		// First line of the checkpoint, a checkpoint of other known blocks or keyspace is not resumed
+		std::string _get_checkpoint_parameters() const;
+
+	private:
+		uint64_t _plaintext_block{};
+		uint64_t _ciphertext_block{};
+
+		std::string _charset;
+		std::string _prefix;
+		size_t _keyword_length{};
+
+		// Key of the keyword with the first symbol of the charset in all free positions
+		uint64_t _base_key{};
+		size_t _free_positions{};
+		uint64_t _keyspace_size{};
+
+		size_t _threads_count{};
+		std::shared_ptr<ncommon::ThreadPool> _thread_pool;
+	};
+}
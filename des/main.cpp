@@ -1,12 +1,71 @@
+#include <iostream>
+#include <string>
+
+#include <charconv>
+#include <cstring>
+
 #include "DES.hpp"
+#include "DESBitslice.hpp"
+#include "DESKeySearch.hpp"
 
-int main()
+// Whole argument must be a number, nothing is thrown for the input of the user
+static bool parse_number(const char* text, int base, uint64_t& value)
 {
-	ndes::DES des;	
+	const char* end = text + std::strlen(text);
+	auto [last, error] = std::from_chars(text, end, value, base);
+	return error == std::errc() and last != text and last == end;
+}
+
+// key_search <plaintext hex> <ciphertext hex> <charset> <prefix> <length> [range index] [ranges count] [threads] [checkpoint file]
+static int run_key_search(int argc, char** argv)
+{
+	uint64_t plaintext_block{}, ciphertext_block{}, keyword_length{};
+	uint64_t range_index{}, ranges_count{ 1 }, threads_count{};
+
+	bool is_valid = argc >= 7 and parse_number(argv[2], 16, plaintext_block) and parse_number(argv[3], 16, ciphertext_block) and parse_number(argv[6], 10, keyword_length);
+	is_valid = is_valid and (argc <= 7 or parse_number(argv[7], 10, range_index));
+	is_valid = is_valid and (argc <= 8 or parse_number(argv[8], 10, ranges_count));
+	is_valid = is_valid and (argc <= 9 or parse_number(argv[9], 10, threads_count));
+
+	if (!is_valid)
+	{
+		std::cout << "Usage: " << argv[0] << " key_search <plaintext hex> <ciphertext hex> <charset> <prefix> <length> [range index] [ranges count] [threads] [checkpoint file]" << std::endl;
+		return 1;
+	}
+
+	ndes::DESKeySearch search;
+	search.set_known_block(plaintext_block, ciphertext_block);
+
+	if (!search.set_keyspace(argv[4], argv[5], static_cast<size_t>(keyword_length)))
+		return 1;
+
+	search.set_threads_count(static_cast<size_t>(threads_count));
+
+	auto ranges = search.split_keyspace(static_cast<size_t>(ranges_count));
+	if (range_index >= ranges.size())
+	{
+		std::cout << "Range index must be less than [" << ranges.size() << "]!" << std::endl;
+		return 1;
+	}
+
+	// DES_KERNEL environment variable forces a kernel
+	std::cout << "DES kernel [" << ndes::DESBitslice::kernel_name() << "]." << std::endl;
+
+	for (const auto& keyword : search.search(ranges[range_index], (argc > 10) ? argv[10] : nullptr))
+		std::cout << "Found keyword [" << keyword << "]." << std::endl;
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc > 1 and std::string(argv[1]) == "key_search")
+		return run_key_search(argc, argv);
+
+	ndes::DES des;
 	if (des.open_data_file("data.txt"))
 	{
 		des.set_keyword("new_keyword");
 		des.encode();
 		des.decode();
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,166 @@
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "../DES.hpp"
+#include "../DESCMAC.hpp"
+
+// Forged files must not pass an authenticated decoder.
+// Built with the DES sources except main.cpp, runs in a directory where it may write its files
+namespace
+{
+	const char* const SOURCE_FILENAME = "auth_source.txt";
+	const char* const ENCODED_FILENAME = "auth_encoded.bin";
+	const char* const FORGED_FILENAME = "auth_forged.bin";
+	const char* const DECODED_FILENAME = "auth_decoded.txt";
+
+	const char* const KEYWORD = "auth_key";
+
+	std::string read_file(const char* filename)
+	{
+		std::ifstream fin(filename, std::ios::binary);
+		std::stringstream ss;
+		ss << fin.rdbuf();
+		return ss.str();
+	}
+
+	void write_file(const char* filename, const std::string& data)
+	{
+		std::ofstream fout(filename, std::ios::binary);
+		fout.write(data.data(), data.size());
+	}
+
+	bool decode_forged(bool is_authenticated)
+	{
+		std::remove(DECODED_FILENAME);
+
+		ndes::DES des(std::string{ KEYWORD });
+		des.set_authenticated(is_authenticated);
+		return des.decode_file(FORGED_FILENAME, DECODED_FILENAME);
+	}
+
+	int check(const char* name, bool is_passed)
+	{
+		std::cout << (is_passed ? "[PASSED] " : "[FAILED] ") << name << std::endl;
+		return is_passed ? 0 : 1;
+	}
+
+	// MAC flag is cleared and the tag is cut off
+	int test_stripped_flag()
+	{
+		ndes::DES des(std::string{ KEYWORD });
+		des.set_mode(ndes::DES_MODE_CTR);
+		des.set_authenticated(true);
+		if (!des.encode_file(SOURCE_FILENAME, ENCODED_FILENAME))
+			return check("stripped flag: encode", false);
+
+		std::string data = read_file(ENCODED_FILENAME);
+		data[6] &= ~ndes::DES_HEADER_FLAG_MAC;
+		data.resize(data.size() - ndes::DES_MAC_SIZE);
+
+		// Bit of the plaintext is flipped, which CTR mode allows
+		data[ndes::DES_HEADER_SIZE] ^= 1;
+		write_file(FORGED_FILENAME, data);
+
+		int failures = check("stripped flag: authenticated decoder rejects it", !decode_forged(true));
+		failures += check("stripped flag: no output", !std::ifstream(DECODED_FILENAME).is_open());
+		failures += check("stripped flag: unauthenticated decoder reads it", decode_forged(false));
+		return failures;
+	}
+
+	// Authenticated index without chunks has nothing to check
+	int test_empty_index()
+	{
+		ndes::DES des(std::string{ KEYWORD });
+		des.set_authenticated(true);
+		des.set_indexed(true);
+		if (!des.encode_file(SOURCE_FILENAME, ENCODED_FILENAME))
+			return check("empty index: encode", false);
+
+		std::string data = read_file(ENCODED_FILENAME);
+		std::string forged = data.substr(0, ndes::DES_HEADER_SIZE) + data.substr(data.size() - ndes::DES_INDEX_TRAILER_SIZE);
+		forged.replace(forged.size() - 8, 8, 8, '\0');
+		write_file(FORGED_FILENAME, forged);
+
+		int failures = check("empty index: authenticated decoder rejects it", !decode_forged(true));
+		failures += check("empty index: decoder of the header flag rejects it", !decode_forged(false));
+
+		write_file(SOURCE_FILENAME, "");
+		failures += check("empty index: encoder refuses empty data", !des.encode_file(SOURCE_FILENAME, ENCODED_FILENAME));
+		failures += check("empty index: no output", !std::ifstream(ENCODED_FILENAME).is_open());
+		return failures;
+	}
+
+	// Chunks of the same data have the same tags in ECB mode, the entry of a changed chunk points to an equal one
+	int test_redirected_chunk()
+	{
+		std::string chunk;
+		while (chunk.size() < ndes::DES_INDEX_CHUNK_SIZE)
+			chunk += "Every chunk of this text is the same. ";
+		chunk.resize(ndes::DES_INDEX_CHUNK_SIZE);
+		write_file(SOURCE_FILENAME, chunk + chunk + chunk);
+
+		ndes::DES des(std::string{ KEYWORD });
+		des.set_authenticated(true);
+		des.set_indexed(true);
+		if (!des.encode_file(SOURCE_FILENAME, ENCODED_FILENAME))
+			return check("redirected chunk: encode", false);
+
+		std::string data = read_file(ENCODED_FILENAME);
+		data[ndes::DES_HEADER_SIZE + ndes::DES_INDEX_CHUNK_SIZE + 5] ^= 1;
+
+		// Entry of chunk 1 gets the offset of chunk 0
+		size_t entry = ndes::DES_HEADER_SIZE + 3 * ndes::DES_INDEX_CHUNK_SIZE + ndes::DES_INDEX_ENTRY_SIZE;
+		data.replace(entry, 8, data, entry - ndes::DES_INDEX_ENTRY_SIZE, 8);
+		write_file(FORGED_FILENAME, data);
+
+		int failures = check("redirected chunk: file rejected", !decode_forged(true));
+		failures += check("redirected chunk: no output", !std::ifstream(DECODED_FILENAME).is_open());
+
+		std::string output;
+		failures += check("redirected chunk: range rejected", !des.decode_range(FORGED_FILENAME, ndes::DES_INDEX_CHUNK_SIZE, 16, output) and output.empty());
+		return failures;
+	}
+
+	// Message without ASCII symbols is empty, its tag still covers the header
+	int test_empty_message()
+	{
+		write_file(SOURCE_FILENAME, "\xC3\xA9");
+		std::remove(ndes::DES_ENCODED_OUTPUT);
+
+		ndes::DES des(std::string{ KEYWORD }, SOURCE_FILENAME);
+		des.set_authenticated(true);
+		des.encode();
+
+		std::string data = read_file(ndes::DES_ENCODED_OUTPUT);
+		int failures = check("empty message: tagged", data.size() == ndes::DES_HEADER_SIZE + ndes::DES_MAC_SIZE);
+
+		std::remove(ndes::DES_DECODED_OUTPUT);
+		ndes::DES decoder(std::string{ KEYWORD });
+		decoder.set_authenticated(true);
+		decoder.decode();
+		failures += check("empty message: decoded", std::ifstream(ndes::DES_DECODED_OUTPUT).is_open());
+
+		// Tag is cut off
+		write_file(ndes::DES_ENCODED_OUTPUT, data.substr(0, ndes::DES_HEADER_SIZE));
+		std::remove(ndes::DES_DECODED_OUTPUT);
+		decoder.decode();
+		failures += check("empty message: no output without the tag", !std::ifstream(ndes::DES_DECODED_OUTPUT).is_open());
+		return failures;
+	}
+}
+
+int main()
+{
+	write_file(SOURCE_FILENAME, "Authenticated data must not be changed without the key.");
+
+	int failures = test_stripped_flag();
+	failures += test_empty_index();
+	failures += test_redirected_chunk();
+	failures += test_empty_message();
+
+	std::cout << (failures ? "Some tests failed!" : "All tests passed.") << std::endl;
+	return failures ? 1 : 0;
+}
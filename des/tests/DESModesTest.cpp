@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "../DES.hpp"
+
+// Known answers of the modes for DES and triple DES, and the batch API against the records one by one.
+// Built with the DES sources except main.cpp, runs in a directory where it may write its files
+namespace
+{
+	// FIPS 81 example, "Now is the time for all "
+	const char* const DES_KEY = "0123456789abcdef";
+	const char* const DES_IV = "1234567890abcdef";
+	const char* const DES_PLAINTEXT = "4e6f77206973207468652074696d6520666f7220616c6c20";
+
+	// SP 800-67 example, "The qufck brown fox jump"
+	const char* const TRIPLE_KEY = "0123456789abcdef23456789abcdef01456789abcdef0123";
+	const char* const TRIPLE_IV = "f69f2445df4f9b17";
+	const char* const TRIPLE_PLAINTEXT = "54686520717566636b2062726f776e20666f78206a756d70";
+
+	struct known_answer
+	{
+		const char* name;
+		bool is_triple;
+		int16_t mode;
+		const char* ciphertext;
+	};
+
+	// CTR counter is the IV, incremented as a 64 bits number for every block
+	const known_answer KNOWN_ANSWERS[] = {
+		{ "DES ECB", false, ndes::DES_MODE_ECB, "3fa40e8a984d48156a271787ab8883f9893d51ec4b563b53" },
+		{ "DES CBC", false, ndes::DES_MODE_CBC, "e5c7cdde872bf27c43e934008c389c0f683788499a7c05f6" },
+		{ "DES CFB", false, ndes::DES_MODE_CFB, "f3096249c7f46e51a69e839b1a92f78403467133898ea622" },
+		{ "DES OFB", false, ndes::DES_MODE_OFB, "f3096249c7f46e5135f24a242eeb3d3f3d6d5be3255af8c3" },
+		{ "DES CTR", false, ndes::DES_MODE_CTR, "f3096249c7f46e51163a8ca0ffc94c27fa2f80f480b86f75" },
+		{ "TDES ECB", true, ndes::DES_MODE_ECB, "a826fd8ce53b855fcce21c8112256fe668d5c05dd9b6b900" },
+		{ "TDES CBC", true, ndes::DES_MODE_CBC, "a5c282bad0de3774becd2e04386b589fb5057d8552fc4336" },
+		{ "TDES CFB", true, ndes::DES_MODE_CFB, "38226c8c06fb8723daefe41f3deb4066ab03b2e1b27fa53e" },
+		{ "TDES OFB", true, ndes::DES_MODE_OFB, "38226c8c06fb8723a4630e658e8204ab6dc490a0943a7d88" },
+		{ "TDES CTR", true, ndes::DES_MODE_CTR, "38226c8c06fb87239bb70db14ce0826f687e1f86ce7dc856" },
+	};
+
+	const char* const SOURCE_FILENAME = "modes_source.txt";
+	const char* const ENCODED_FILENAME = "modes_encoded.bin";
+	const char* const DECODED_FILENAME = "modes_decoded.txt";
+
+	std::string read_file(const char* filename)
+	{
+		std::ifstream fin(filename, std::ios::binary);
+		std::stringstream ss;
+		ss << fin.rdbuf();
+		return ss.str();
+	}
+
+	void write_file(const char* filename, const std::string& data)
+	{
+		std::ofstream fout(filename, std::ios::binary);
+		fout.write(data.data(), data.size());
+	}
+
+	std::vector<uint8_t> from_hex(const char* hex)
+	{
+		std::vector<uint8_t> bytes;
+		for (size_t i = 0; hex[i] and hex[i + 1]; i += 2)
+			bytes.push_back(static_cast<uint8_t>(std::stoul(std::string(hex + i, 2), nullptr, 16)));
+		return bytes;
+	}
+
+	uint64_t to_block(const std::vector<uint8_t>& bytes)
+	{
+		uint64_t block{};
+		for (auto byte : bytes)
+			block = (block << 8) | byte;
+		return block;
+	}
+
+	int check(const std::string& name, bool is_passed)
+	{
+		std::cout << (is_passed ? "[PASSED] " : "[FAILED] ") << name << std::endl;
+		return is_passed ? 0 : 1;
+	}
+
+	int test_known_answer(const known_answer& answer)
+	{
+		std::vector<uint8_t> key = from_hex(answer.is_triple ? TRIPLE_KEY : DES_KEY);
+		std::vector<uint8_t> plaintext = from_hex(answer.is_triple ? TRIPLE_PLAINTEXT : DES_PLAINTEXT);
+		std::vector<uint8_t> ciphertext = from_hex(answer.ciphertext);
+
+		ndes::DES des;
+		if (answer.is_triple)
+			des.set_triple_keyword(std::string(key.begin(), key.end()));
+		else
+			des.set_keyword(std::string(key.begin(), key.end()));
+		des.set_mode(answer.mode);
+		des.set_iv(to_block(from_hex(answer.is_triple ? TRIPLE_IV : DES_IV)));
+
+		std::vector<uint8_t> output(plaintext.size());
+		int failures = check(std::string(answer.name) + ": encrypt", des.encrypt(plaintext, output) and output == ciphertext);
+
+		// Decryption in place
+		failures += check(std::string(answer.name) + ": decrypt", des.decrypt(output, output) and output == plaintext);
+		return failures;
+	}
+
+	// Many chunks of blocks go through the bitsliced kernels and the threads, every block must still match
+	int test_long_message()
+	{
+		std::vector<uint8_t> key = from_hex(TRIPLE_KEY);
+		std::vector<uint8_t> data(ndes::DES_CHUNK_BLOCKS * 8 * 5 + 24);
+		for (size_t i = 0; i < data.size(); ++i)
+			data[i] = static_cast<uint8_t>(i * 131 + 7);
+
+		int failures{};
+		for (int16_t mode = ndes::DES_MODE_ECB; mode <= ndes::DES_MODE_CTR; ++mode)
+		{
+			ndes::DES des;
+			des.set_triple_keyword(std::string(key.begin(), key.end()));
+			des.set_mode(mode);
+			des.set_iv(to_block(from_hex(TRIPLE_IV)));
+			des.set_threads_count(4);
+
+			std::vector<uint8_t> encoded(data.size()), decoded(data.size());
+			des.encrypt(data, encoded);
+
+			// Same message one block at a time, the chain is carried by hand
+			bool is_equal = true;
+			uint64_t chain = to_block(from_hex(TRIPLE_IV));
+			for (size_t offset = 0; offset < data.size() and is_equal; offset += 8)
+			{
+				ndes::DES block_des;
+				block_des.set_triple_keyword(std::string(key.begin(), key.end()));
+				block_des.set_mode(mode);
+				block_des.set_iv(chain);
+
+				uint8_t block[8];
+				block_des.encrypt(std::span<const uint8_t>(data.data() + offset, 8), block);
+				is_equal = std::equal(block, block + 8, encoded.begin() + offset);
+
+				if (mode == ndes::DES_MODE_CBC or mode == ndes::DES_MODE_CFB)
+					chain = to_block(std::vector<uint8_t>(block, block + 8));
+				else if (mode == ndes::DES_MODE_OFB)
+					chain = to_block(std::vector<uint8_t>(block, block + 8)) ^ to_block(std::vector<uint8_t>(data.begin() + offset, data.begin() + offset + 8));
+				else if (mode == ndes::DES_MODE_CTR)
+					++chain;
+			}
+
+			std::string name = "long message, mode " + std::to_string(mode);
+			failures += check(name + ": matches block by block", is_equal);
+			failures += check(name + ": round trip", des.decrypt(encoded, decoded) and decoded == data);
+		}
+		return failures;
+	}
+
+	// Every encoded file gets its own IV, decoding takes the mode and IV of the file and keeps the ones of the caller
+	int test_header_parameters()
+	{
+		const std::string source = "Same data with the same key must not give the same file twice.";
+		write_file(SOURCE_FILENAME, source);
+
+		ndes::DES des(std::string{ "mode_key" });
+		des.set_mode(ndes::DES_MODE_CBC);
+
+		des.encode_file(SOURCE_FILENAME, ENCODED_FILENAME);
+		std::string first = read_file(ENCODED_FILENAME);
+		des.encode_file(SOURCE_FILENAME, ENCODED_FILENAME);
+		std::string second = read_file(ENCODED_FILENAME);
+
+		int failures = check("header: random IV differs", first.size() == second.size() and first.compare(8, 8, second, 8, 8) != 0);
+		failures += check("header: file decodes", des.decode_file(ENCODED_FILENAME, DECODED_FILENAME) and read_file(DECODED_FILENAME) == source);
+
+		// File of another mode and IV
+		ndes::DES other(std::string{ "mode_key" });
+		other.set_mode(ndes::DES_MODE_CTR);
+		other.set_iv(0x0123456789abcdef);
+		other.encode_file(SOURCE_FILENAME, ENCODED_FILENAME);
+		std::string fixed = read_file(ENCODED_FILENAME);
+		other.encode_file(SOURCE_FILENAME, ENCODED_FILENAME);
+		failures += check("header: IV set by the caller is kept", fixed == read_file(ENCODED_FILENAME));
+
+		failures += check("header: other mode decodes", des.decode_file(ENCODED_FILENAME, DECODED_FILENAME) and read_file(DECODED_FILENAME) == source);
+
+		des.encode_file(SOURCE_FILENAME, ENCODED_FILENAME);
+		std::string next = read_file(ENCODED_FILENAME);
+		failures += check("header: caller mode kept after decoding", next.size() > 4 and next[4] == ndes::DES_MODE_CBC and next.compare(8, 8, fixed, 8, 8) != 0);
+		return failures;
+	}
+
+	// Records with different keys and sizes give the same blocks as the ECB of every record alone
+	int test_batch()
+	{
+		const size_t records_count = 200;
+
+		std::vector<std::vector<uint8_t>> keys(records_count), data(records_count);
+		std::vector<ndes::des_record> records;
+		for (size_t i = 0; i < records_count; ++i)
+		{
+			keys[i].resize(ndes::DES_KEY_SIZE);
+			for (size_t k = 0; k < keys[i].size(); ++k)
+				keys[i][k] = static_cast<uint8_t>(i * 31 + k * 17 + 1);
+
+			data[i].resize(8 * (i % 5));
+			for (size_t k = 0; k < data[i].size(); ++k)
+				data[i][k] = static_cast<uint8_t>(i + k * 3);
+
+			records.push_back({ keys[i], data[i] });
+		}
+
+		std::vector<std::vector<uint8_t>> original = data;
+
+		ndes::DES batch;
+		int failures = check("batch: encrypt", batch.encrypt_batch(records));
+
+		bool is_equal = true;
+		for (size_t i = 0; i < records_count; ++i)
+		{
+			ndes::DES des(std::string(keys[i].begin(), keys[i].end()));
+			std::vector<uint8_t> expected(original[i].size());
+			des.encrypt(original[i], expected);
+			is_equal = is_equal and expected == data[i];
+		}
+		failures += check("batch: matches ECB of every record", is_equal);
+
+		failures += check("batch: decrypt", batch.decrypt_batch(records) and data == original);
+
+		// Key of a wrong size, nothing is changed
+		std::vector<uint8_t> short_key(ndes::DES_KEY_SIZE - 1);
+		records.push_back({ short_key, data[1] });
+		failures += check("batch: invalid record rejected", !batch.encrypt_batch(records) and data == original);
+		return failures;
+	}
+}
+
+int main()
+{
+	int failures{};
+	for (const auto& answer : KNOWN_ANSWERS)
+		failures += test_known_answer(answer);
+
+	failures += test_long_message();
+	failures += test_header_parameters();
+	failures += test_batch();
+
+	std::cout << (failures ? "Some tests failed!" : "All tests passed.") << std::endl;
+	return failures ? 1 : 0;
+}
@@ -1,9 +1,55 @@
 #include "RSA.hpp"
+#include "RSADecimal.hpp"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <iterator>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <thread>
+
+namespace
+{
+	void write_uint32(char* bytes, uint32_t value)
+	{
+		for (size_t i = 0; i < 4; ++i)
+			bytes[i] = static_cast<char>(value >> (8 * i));
+	}
+
+	uint32_t read_uint32(const char* bytes)
+	{
+		uint32_t value{};
+		for (size_t i = 0; i < 4; ++i)
+			value |= static_cast<uint32_t>(static_cast<uint8_t>(bytes[i])) << (8 * i);
+		return value;
+	}
+
+	// Count of limbs and the limbs
+	void append_number(std::string& data, const nrsa::RSABigInt& value)
+	{
+		size_t position = data.size();
+		data.resize(position + 4 + 8 * value.limbs_count());
+
+		write_uint32(data.data() + position, static_cast<uint32_t>(value.limbs_count()));
+		value.to_little_endian(data.data() + position + 4, value.limbs_count());
+	}
+
+	bool read_number(const std::string& data, size_t& position, nrsa::RSABigInt& value)
+	{
+		if (data.size() - position < 4)
+			return false;
+
+		size_t limbs_count = read_uint32(data.data() + position);
+		if ((data.size() - position - 4) / 8 < limbs_count)
+			return false;
+
+		value = nrsa::RSABigInt::from_little_endian(data.data() + position + 4, limbs_count);
+		position += 4 + 8 * limbs_count;
+		return true;
+	}
+}
 
 nrsa::RSA::RSA()
 {
@@ -15,31 +61,57 @@ nrsa::RSA::RSA(uint64_t seed) : _seed(seed)
 	_init();
 }
 
+bool nrsa::RSA::set_key_size(size_t key_size)
+{
+	if (key_size < RSA_MIN_KEY_SIZE)
+	{
+		std::cout << "Key size must be at least " << RSA_MIN_KEY_SIZE << " bits!\n" << std::endl;
+		return false;
+	}
+
+	_key_size = key_size;
+	return true;
+}
+
 void nrsa::RSA::generate_keys()
 {
-	uint64_t p{}, q{}, totient{};
+	RSABigInt p, q, totient;
 
-	p = _get_prime_num();
-	q = _get_prime_num();
-	std::cout << "p - " << p << std::endl;
-	std::cout << "q - " << q << std::endl;
+	// Open exponent is fixed, so the primes are changed until it is coprime with the totient
+	do
+	{
+		p = _get_prime_num(_key_size / 2);
+		q = _get_prime_num(_key_size - _key_size / 2);
+
+		while (q == p)
+			q = _get_prime_num(_key_size - _key_size / 2);
 
-	while (q == p)
-		q = _get_prime_num();
+		totient = (p - 1) * (q - 1);
+		_open_exp = _calc_e(totient);
+	} while (_open_exp.is_zero());
+
+	std::cout << "p - " << p.to_string() << std::endl;
+	std::cout << "q - " << q.to_string() << std::endl;
 
 	_modulus = p * q;
-	
-	totient = (p - 1) * (q - 1);
-	std::cout << "phi(n) - " << totient << std::endl;
+	_create_modulus_context();
+
+	std::cout << "phi(n) - " << totient.to_string() << std::endl;
 
-	_open_exp = _calc_e(totient, p, q);
 	_secret_exp = _calc_d(totient, _open_exp);
+	_set_factors(p, q);
 }
 
 void nrsa::RSA::show_keys()
 {
-	std::cout << "Public key [e n]: (" << _open_exp << " " << _modulus << ")" << std::endl;
-	std::cout << "Private key [d n]: (" << _secret_exp << " " << _modulus << ")\n" << std::endl;
+	std::cout << "Public key [e n]: (" << _open_exp.to_string() << " " << _modulus.to_string() << ")" << std::endl;
+	std::cout << "Private key [d n]: (" << _secret_exp.to_string() << " " << _modulus.to_string() << ")\n" << std::endl;
+
+	if (_prime_p_context)
+	{
+		std::cout << "Private key CRT [p q dP dQ qInv]: (" << _prime_p.to_string() << " " << _prime_q.to_string() << " " << _exp_p.to_string()
+			<< " " << _exp_q.to_string() << " " << _q_inverse.to_string() << ")\n" << std::endl;
+	}
 }
 
 bool nrsa::RSA::save_keys(const char* filename)
@@ -55,6 +127,12 @@ bool nrsa::RSA::save_keys(const char* filename)
 
 bool nrsa::RSA::load_keys(const char* filename_pub, const char* filename_priv)
 {
+	if (not filename_pub)
+		filename_pub = _is_binary ? RSA_PUBLIC_KEY_BINARY_FILENAME : RSA_PUBLIC_KEY_FILENAME;
+
+	if (not filename_priv)
+		filename_priv = _is_binary ? RSA_PRIVATE_KEY_BINARY_FILENAME : RSA_PRIVATE_KEY_FILENAME;
+
 	if (not _load_key(filename_pub, false))
 		return false;
 
@@ -72,18 +150,27 @@ void nrsa::RSA::_init()
 		_mt64.seed(_seed);
 	else
 	{
+		// The whole state of the generator comes from the random device, one number of it would give only 2^32 states
 		std::random_device rd;
-		_mt64.seed(rd());
+		std::array<uint32_t, 2 * std::mt19937_64::state_size> seed_data;
+		std::generate(seed_data.begin(), seed_data.end(), std::ref(rd));
+
+		std::seed_seq seed_sequence(seed_data.begin(), seed_data.end());
+		_mt64.seed(seed_sequence);
 	}
 }
 
-uint64_t nrsa::RSA::_get_prime_num(uint64_t _mod)
+nrsa::RSABigInt nrsa::RSA::_get_prime_num(size_t bits)
 {
-	uint64_t val{};
-	
+	RSABigInt val;
+
+	// Two top bits make the product of two primes exactly twice longer
 	do
 	{
-		val = _rand() % _mod;
+		val = _rand_bits(bits);
+		val.set_bit(bits - 1);
+		val.set_bit(bits - 2);
+		val.set_bit(0);
 	} while (not is_prime_num(val));
 
 	return val;
@@ -94,36 +181,111 @@ bool nrsa::RSA::is_prime_num(uint64_t val)
 	return _miller_rabin_prime(val);
 }
 
-bool nrsa::RSA::encode(const char* filename)
+bool nrsa::RSA::is_prime_num(const RSABigInt& val)
 {
-	std::string source_data;
+	if (val.limbs_count() <= 1)
+		return _miller_rabin_prime(val.low_limb());
 
-	if (_secret_exp == 0 or _modulus == 0)
+	// Most of the composite numbers have a small divisor, it is cheaper than one round of Miller-Rabin
+	for (uint64_t prime : _get_small_primes())
+		if (val.mod_small(prime) == 0)
+			return false;
+
+	return _miller_rabin_prime(val);
+}
+
+bool nrsa::RSA::encode(const char* filename)
+{
+	if (_secret_exp.is_zero() or _modulus.is_zero())
 	{
 		generate_keys();
 		save_keys();
 	}
 
-	if (not _read_file_data(filename, source_data))
+	std::ifstream fin(filename);
+	if (not fin.is_open())
+	{
+		std::cout << "Cannot open file [" << filename << "] to encode!\n" << std::endl;
+		return false;
+	}
+
+	const char* encoded_filename = _is_binary ? RSA_ENCODED_BINARY_FILENAME : RSA_ENCODED_DATA_FILENAME;
+
+	std::ofstream fout(encoded_filename, std::ios::binary);
+	if (not fout.is_open())
+	{
+		std::cout << "Cannot open file [" << encoded_filename << "] to write!\n" << std::endl;
+		return false;
+	}
+
+	// Every value of the binary data has the limbs of the modulus
+	if (_is_binary)
+	{
+		char header[RSA_BINARY_HEADER_SIZE]{};
+		std::copy(RSA_DATA_MAGIC, RSA_DATA_MAGIC + 3, header);
+		header[3] = RSA_BINARY_VERSION;
+		write_uint32(header + 4, static_cast<uint32_t>(_modulus.limbs_count()));
+		fout.write(header, RSA_BINARY_HEADER_SIZE);
+	}
+
+	if (not _process_file(fin, fout, false))
 		return false;
 
-	return _encode_data(_remove_non_ascii(source_data));
+	std::cout << "Source data was encoded and written to file [" << encoded_filename << "].\n" << std::endl;
+	return true;
 }
 
 bool nrsa::RSA::decode(const char* filename)
 {
-	std::string encoded_data;
-
-	if (_open_exp == 0 or _modulus == 0)
+	if (_open_exp.is_zero() or _modulus.is_zero())
 	{
 		std::cout << "Firstly, you need to load your keys!\n" << std::endl;
 		return false;
 	}
 
-	if (not _read_file_data(filename, encoded_data, true))
+	if (not filename)
+		filename = _is_binary ? RSA_ENCODED_BINARY_FILENAME : RSA_ENCODED_DATA_FILENAME;
+
+	std::ifstream fin(filename, std::ios::binary);
+	if (not fin.is_open())
+	{
+		std::cout << "Cannot open file [" << filename << "] to decode!\n" << std::endl;
+		return false;
+	}
+
+	char magic[3]{};
+	fin.read(magic, 3);
+	bool is_binary_data = fin and std::equal(magic, magic + 3, RSA_DATA_MAGIC);
+
+	fin.clear();
+	fin.seekg(0);
+
+	std::ofstream fout(RSA_DECODED_DATA_FILENAME);
+	if (not fout.is_open())
+	{
+		std::cout << "Cannot open file [" << RSA_DECODED_DATA_FILENAME << "] to write!\n" << std::endl;
+		return false;
+	}
+
+	if (is_binary_data)
+	{
+		fin.close();
+
+		ncommon::MappedFile mapped_fin;
+		if (not mapped_fin.open(filename))
+		{
+			std::cout << "Cannot map file [" << filename << "] to decode!\n" << std::endl;
+			return false;
+		}
+
+		if (not _decode_binary_file(mapped_fin, fout))
+			return false;
+	}
+	else if (not _process_file(fin, fout, true))
 		return false;
 
-	return _decode_data(encoded_data);
+	std::cout << "Encoded data was decoded and written to file [" << RSA_DECODED_DATA_FILENAME << "].\n" << std::endl;
+	return true;
 }
 
 bool nrsa::RSA::_miller_rabin_prime(uint64_t val, int16_t iterations)
@@ -142,20 +304,27 @@ bool nrsa::RSA::_miller_rabin_prime(uint64_t val, int16_t iterations)
 		d >>= 1;
 	}
 	
+	// Montgomery constants are computed once for all the rounds
+	RSAMontgomery64 modulus(val);
+	uint64_t minus_one = modulus.to_form(val - 1);
+
 	// Now take a random integer between [2, val) as a
 	for (int16_t i = 0; i <= iterations; ++i) 
 	{
 		uint64_t a = _rand(2, val - 1);
-		uint64_t x = _pow_mod(a, d, val);
+		uint64_t x = modulus.pow_mod(a, d);
 		
 		if (x == 1 || x == (val - 1)) 
 			continue;
 		
-		int16_t j{};
+		// Squares stay in the Montgomery form
+		x = modulus.to_form(x);
+
+		uint64_t j{};
 		for (j = 0; j < s; ++j) 
 		{
-			x = _multiply_mod1(x, x, val);
-			if (x == (val - 1))
+			x = modulus.multiply(x, x);
+			if (x == minus_one)
 				break;
 		}
 
@@ -168,92 +337,94 @@ bool nrsa::RSA::_miller_rabin_prime(uint64_t val, int16_t iterations)
 	return true;
 }
 
-uint64_t nrsa::RSA::_pow_mod(uint64_t base, uint64_t exp, uint64_t modulus)
+bool nrsa::RSA::_miller_rabin_prime(const RSABigInt& val, int16_t iterations)
 {
-	// https://stackoverflow.com/a/8498251
-	base %= modulus;
+	// Now our num is odd number greater than 2^64
+	RSAMontgomery modulus(val);
 
-	uint64_t result = 1;
-	while (exp > 0) 
+	RSABigInt val_minus_one = val - 1;
+	RSABigInt d = val_minus_one;
+	size_t s{};
+
+	while (not d.is_odd())
 	{
-		if (exp & 1) result = _multiply_mod1(result, base, modulus);
-			base = _multiply_mod1(base, base, modulus);
-		exp >>= 1;
+		++s;
+		d >>= 1;
 	}
-	return result;
-}
 
-uint64_t nrsa::RSA::_multiply_mod1(uint64_t val1, uint64_t val2, uint64_t modulus)
-{
-	// https://stackoverflow.com/a/18680280
+	RSABigInt minus_one = modulus.to_form(val_minus_one);
 
-	uint64_t res = 0;
-	uint64_t temp_val2;
-
-	/* Only needed if val2 may be >= modulus */
-	if (val2 >= modulus) 
+	for (int16_t i = 0; i <= iterations; ++i)
 	{
-		if (modulus > UINT64_MAX / 2u)
-			val2 -= modulus;
-		else
-			val2 %= modulus;
-	}
+		RSABigInt x = _pow_mod(_rand(2, val_minus_one - 1), d, modulus);
 
-	while (val1 != 0) 
-	{
-		if (val1 & 1) 
+		if (x == 1 or x == val_minus_one)
+			continue;
+
+		// Squares stay in the Montgomery form
+		x = modulus.to_form(x);
+
+		size_t j{};
+		for (j = 0; j < s; ++j)
 		{
-			/* Add val2 to res, modulus, without overflow */
-			/* Equiv to if (res + val2 >= modulus), without overflow */
-			if (val2 >= modulus - res)
-				res -= modulus;
-			res += val2;
+			x = modulus.multiply(x, x);
+			if (x == minus_one)
+				break;
 		}
-		val1 >>= 1;
 
-		/* Double val2, modulo modulus */
-		temp_val2 = val2;
-
-		/* Equiv to if (2 * val2 >= modulus), without overflow */
-		if (val2 >= modulus - val2)
-			temp_val2 -= modulus;
-		val2 += temp_val2;
+		// val is composite
+		if (j == s)
+			return false;
 	}
-	return res;
+
+	// val is probable prime
+	return true;
 }
 
-uint64_t nrsa::RSA::_multiply_mod2(uint64_t val1, uint64_t val2, uint64_t modulus)
+uint64_t nrsa::RSA::_pow_mod(uint64_t base, uint64_t exp, uint64_t modulus)
 {
-	// https://www.rosettacode.org/wiki/Miller%E2%80%93Rabin_primality_test#C++
+	// Odd modulus goes by the Montgomery form without any division
+	if (modulus & 1)
+		return RSAMontgomery64(modulus).pow_mod(base, exp);
 
-	uint64_t am = (val1 < modulus) ? val1 : val1 % modulus;
-	uint64_t bm = (val2 < modulus) ? val2 : val2 % modulus;
-	if (bm > am) {
-		std::swap(am, bm);
-	}
-	uint64_t result{};
-	while (bm > 0) {
-		if ((bm & 1) == 1) {
-			result = _add_mod(result, am, modulus);
-		}
-		am = (am << 1) - (am >= (modulus - am) ? modulus : 0);
-		bm >>= 1;
+	// https://stackoverflow.com/a/8498251
+	base %= modulus;
+
+	uint64_t result = 1;
+	while (exp > 0) 
+	{
+		if (exp & 1) result = _multiply_mod(result, base, modulus);
+			base = _multiply_mod(base, base, modulus);
+		exp >>= 1;
 	}
 	return result;
 }
 
-uint64_t nrsa::RSA::_add_mod(uint64_t val1, uint64_t val2, uint64_t modulus)
+nrsa::RSABigInt nrsa::RSA::_pow_mod(const RSABigInt& base, const RSABigInt& exp, const RSAMontgomery& modulus)
 {
-	uint64_t am = (val1 < modulus) ? val1 : val1 % modulus;
-	if (val2 == 0) {
-		return am;
-	}
-	uint64_t bm = (val2 < modulus) ? val2 : val2 % modulus;
-	uint64_t b_from_m = modulus - bm;
-	if (am >= b_from_m) {
-		return am - b_from_m;
-	}
-	return am + bm;
+	return modulus.pow_mod(base, exp);
+}
+
+nrsa::RSABigInt nrsa::RSA::_private_pow_mod(const RSABigInt& val)
+{
+	if (not _prime_p_context)
+		return _pow_mod(val, _secret_exp, *_modulus_context);
+
+	// Two exponentiations of the half size, Garner: m = m_q + q * ((m_p - m_q) * q^-1 mod p), m_q < q < p
+	RSABigInt m_p = _pow_mod(val, _exp_p, *_prime_p_context);
+	RSABigInt m_q = _pow_mod(val, _exp_q, *_prime_q_context);
+
+	RSABigInt h = (m_p + _prime_p - m_q) * _q_inverse % _prime_p;
+	return m_q + h * _prime_q;
+}
+
+uint64_t nrsa::RSA::_multiply_mod(uint64_t val1, uint64_t val2, uint64_t modulus)
+{
+	// Product of two limbs always fits in 128 bits, its high limb is reduced first for the division of one limb
+	uint64_t high{}, remainder{};
+	uint64_t low = multiply_wide(val1, val2, high);
+	divide_wide(high % modulus, low, modulus, remainder);
+	return remainder;
 }
 
 uint64_t nrsa::RSA::_rand()
@@ -267,49 +438,69 @@ uint64_t nrsa::RSA::_rand(uint64_t _left, uint64_t _right)
 	return dist(_mt64);
 }
 
-uint64_t nrsa::RSA::_calc_e(uint64_t totient, uint64_t p, uint64_t q)
+nrsa::RSABigInt nrsa::RSA::_rand(const RSABigInt& _left, const RSABigInt& _right)
+{
+	// Numbers of the same bits as the range until one fits in it
+	RSABigInt range = _right - _left;
+	RSABigInt val;
+
+	do
+	{
+		val = _rand_bits(range.bits_count());
+	} while (val > range);
+
+	return val += _left;
+}
+
+nrsa::RSABigInt nrsa::RSA::_rand_bits(size_t bits)
 {
-	uint64_t e = _rand(std::max(p, q), totient - 1);
+	std::vector<limb_type> limbs((bits + 63) / 64);
+	for (auto& limb : limbs)
+		limb = _rand();
+
+	if (bits % 64)
+		limbs.back() &= (limb_type{ 1 } << (bits % 64)) - 1;
+
+	return RSABigInt::from_limbs(limbs.data(), limbs.size());
+}
 
-	while (_gcd(e, totient) != 1)
-		e = _rand(std::max(p, q), totient - 1);
+nrsa::RSABigInt nrsa::RSA::_calc_e(const RSABigInt& totient)
+{
+	if (_gcd(RSA_OPEN_EXP, totient) != 1)
+		return RSABigInt();
 
-	//for (; e < totient; ++e)
-	//	if (_gcd(e, totient) == 1)
-	//		break;
-	return e;
+	return RSA_OPEN_EXP;
 }
 
-uint64_t nrsa::RSA::_calc_d(uint64_t totient, uint64_t e)
+nrsa::RSABigInt nrsa::RSA::_calc_d(const RSABigInt& totient, const RSABigInt& e)
 {
 	return _ext_gcd(e, totient);
 }
 
-uint64_t nrsa::RSA::_gcd(uint64_t a, uint64_t b)
+nrsa::RSABigInt nrsa::RSA::_gcd(RSABigInt a, RSABigInt b)
 {
-	while (b) 
+	while (not b.is_zero())
 	{
-		a %= b;
+		a = a % b;
 		std::swap(a, b);
 	}
 	return a;
 }
 
-uint64_t nrsa::RSA::_ext_gcd(uint64_t u, uint64_t v)
+nrsa::RSABigInt nrsa::RSA::_ext_gcd(const RSABigInt& u, const RSABigInt& v)
 {
 	// https://stackoverflow.com/a/27736785
 
-	uint64_t u1, u3, v1, v3, t1, t3, q;
+	RSABigInt u1, u3, v1, v3, t1, t3, q;
 	int64_t iter;
 	u1 = 1;
 	u3 = u;
 	v1 = 0;
 	v3 = v;
 	iter = 1;
-	while (v3 != 0)
+	while (not v3.is_zero())
 	{
-		q = u3 / v3;
-		t3 = u3 % v3;
+		RSABigInt::divide(u3, v3, q, t3);
 		t1 = u1 + q * v1;
 		u1 = v1;
 		v1 = t1;
@@ -318,10 +509,34 @@ uint64_t nrsa::RSA::_ext_gcd(uint64_t u, uint64_t v)
 		iter = -iter;
 	}
 	if (u3 != 1)
-		return  0;
+		return 0;
 	return (iter < 0) ? v - u1 : u1;
 }
 
+const std::vector<uint64_t>& nrsa::RSA::_get_small_primes()
+{
+	static const std::vector<uint64_t> small_primes = _create_small_primes();
+	return small_primes;
+}
+
+std::vector<uint64_t> nrsa::RSA::_create_small_primes()
+{
+	// Sieve of Eratosthenes
+	std::vector<bool> is_composite(RSA_SMALL_PRIMES_LIMIT, false);
+	std::vector<uint64_t> small_primes;
+
+	for (uint64_t i = 2; i < RSA_SMALL_PRIMES_LIMIT; ++i)
+	{
+		if (is_composite[i])
+			continue;
+
+		small_primes.push_back(i);
+		for (uint64_t j = i * i; j < RSA_SMALL_PRIMES_LIMIT; j += i)
+			is_composite[j] = true;
+	}
+	return small_primes;
+}
+
 bool nrsa::RSA::_save_key(std::string filename, bool is_private)
 {
 	std::ofstream fout;
@@ -329,13 +544,28 @@ bool nrsa::RSA::_save_key(std::string filename, bool is_private)
 	if (not is_private)
 		filename += "_pub";
 
-	fout.open(filename + ".txt");
+	fout.open(filename + (_is_binary ? ".bin" : ".txt"), std::ios::binary);
 	if (not fout.is_open())
 	{
 		std::cout << "Cannot open file [" << filename << "] to save!\n" << std::endl;
 		return false;
 	}
-	fout << (is_private ? _secret_exp : _open_exp) << " " << _modulus;
+
+	if (_is_binary)
+	{
+		std::string key_data = _write_binary_key(is_private);
+		fout.write(key_data.data(), key_data.size());
+		return static_cast<bool>(fout);
+	}
+
+	fout << (is_private ? _secret_exp : _open_exp).to_string() << " " << _modulus.to_string();
+
+	// Private key goes on with the factors, the readers of two numbers just skip them
+	if (is_private and _prime_p_context)
+	{
+		fout << " " << _prime_p.to_string() << " " << _prime_q.to_string() << " " << _exp_p.to_string()
+			<< " " << _exp_q.to_string() << " " << _q_inverse.to_string();
+	}
 	fout.close();
 
 	return true;
@@ -345,36 +575,187 @@ bool nrsa::RSA::_load_key(const std::string& filename, bool is_private)
 {
 	std::ifstream fin;
 
-	fin.open(filename);
+	fin.open(filename, std::ios::binary);
 	if (not fin.is_open())
 	{
 		std::cout << "Cannot open file [" << filename << "] to load!\n" << std::endl;
 		return false;
 	}
-	fin >> (is_private ? _secret_exp : _open_exp) >> _modulus;
+	std::string key_data((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
 	fin.close();
 
+	rsa_key key;
+	bool is_binary_key = key_data.size() >= RSA_BINARY_HEADER_SIZE and std::equal(RSA_KEY_MAGIC, RSA_KEY_MAGIC + 3, key_data.begin());
+	bool is_read = is_binary_key ? _read_binary_key(key_data, is_private, key) : _read_text_key(key_data, is_private, key);
+
+	// Modulus of a key is a product of two odd primes
+	if (not is_read or not key.modulus.is_odd() or key.modulus == 1)
+	{
+		std::cout << "Wrong key in file [" << filename << "]!\n" << std::endl;
+		return false;
+	}
+
+	// Factors depend on both the modulus and the secret exponent
+	if (is_private or key.modulus != _modulus)
+		_clear_factors();
+
+	(is_private ? _secret_exp : _open_exp) = key.exp;
+	_modulus = key.modulus;
+
+	if (key.contexts[0])
+		_modulus_context = key.contexts[0];
+	_create_modulus_context();
+
+	if (key.factors.empty())
+		return true;
+
+	// Factors are used only when they agree with the modulus and the secret exponent
+	const std::vector<RSABigInt>& factors = key.factors;
+	if (factors.size() != 5 or not factors[0].is_odd() or not factors[1].is_odd() or factors[0] <= factors[1] or factors[1] == 1
+		or factors[0] * factors[1] != _modulus)
+	{
+		std::cout << "Wrong CRT part of the key in file [" << filename << "]!\n" << std::endl;
+		return false;
+	}
+
+	_set_factors(factors[0], factors[1], key.contexts[1], key.contexts[2]);
+	if (_exp_p != factors[2] or _exp_q != factors[3] or _q_inverse != factors[4])
+	{
+		_clear_factors();
+		std::cout << "Wrong CRT part of the key in file [" << filename << "]!\n" << std::endl;
+		return false;
+	}
+
 	return true;
 }
 
-bool nrsa::RSA::_read_file_data(const std::string& filename, std::string& read_data, bool is_decode)
+bool nrsa::RSA::_read_text_key(const std::string& key_data, bool is_private, rsa_key& key)
 {
-	std::ifstream fin;
+	std::istringstream fin(key_data);
 
-	fin.open(filename);
-	if (not fin.is_open())
+	std::string exp_text, modulus_text;
+	fin >> exp_text >> modulus_text;
+
+	if (not RSABigInt::from_string(exp_text, key.exp) or not RSABigInt::from_string(modulus_text, key.modulus))
+		return false;
+
+	// Private key can have p, q, dP, dQ and qInv after the modulus
+	for (std::string factor_text; is_private and fin >> factor_text;)
 	{
-		std::cout << "Cannot open file [" << filename << "] to " << (is_decode ? "decode" : "encode") << "!\n" << std::endl;
+		key.factors.emplace_back();
+		if (not RSABigInt::from_string(factor_text, key.factors.back()))
+			return false;
+	}
+	return true;
+}
+
+bool nrsa::RSA::_read_binary_key(const std::string& key_data, bool is_private, rsa_key& key)
+{
+	char flags = key_data[4];
+	if (key_data[3] != RSA_BINARY_VERSION or ((flags & RSA_KEY_FLAG_PRIVATE) != 0) != is_private
+		or (flags & ~(RSA_KEY_FLAG_PRIVATE | RSA_KEY_FLAG_FACTORS | RSA_KEY_FLAG_MONTGOMERY)) != 0)
 		return false;
+
+	size_t position = RSA_BINARY_HEADER_SIZE;
+	if (not read_number(key_data, position, key.exp) or not read_number(key_data, position, key.modulus))
+		return false;
+
+	if (flags & RSA_KEY_FLAG_FACTORS)
+	{
+		key.factors.resize(5);
+		for (auto& factor : key.factors)
+			if (not read_number(key_data, position, factor))
+				return false;
 	}
 
-	std::stringstream ss;
-	ss << fin.rdbuf();
-	fin.close();
+	// Contexts are not trusted blindly: the inverse is checked by one multiplication and R^2 by the form of one
+	if (flags & RSA_KEY_FLAG_MONTGOMERY)
+	{
+		const RSABigInt* moduli[3] = { &key.modulus, key.factors.empty() ? nullptr : &key.factors[0], key.factors.empty() ? nullptr : &key.factors[1] };
+		for (size_t i = 0; i < 3 and moduli[i]; ++i)
+		{
+			RSABigInt modulus_inverse, r2;
+			if (not read_number(key_data, position, modulus_inverse) or not read_number(key_data, position, r2))
+				return false;
 
-	read_data = ss.str();
+			if (not moduli[i]->is_odd() or modulus_inverse.limbs_count() != 1 or moduli[i]->low_limb() * modulus_inverse.low_limb() != UINT64_MAX
+				or r2 >= *moduli[i])
+				return false;
 
-	return true;
+			// One comes back from the Montgomery form only with the right R^2, it costs two multiplications instead of a division
+			auto context = std::make_shared<const RSAMontgomery>(*moduli[i], modulus_inverse.low_limb(), r2);
+			if (context->from_form(context->to_form(1)) != 1)
+				return false;
+
+			key.contexts[i] = context;
+		}
+	}
+
+	return position == key_data.size();
+}
+
+std::string nrsa::RSA::_write_binary_key(bool is_private)
+{
+	bool has_factors = is_private and _prime_p_context;
+
+	std::string key_data(RSA_BINARY_HEADER_SIZE, '\0');
+	std::copy(RSA_KEY_MAGIC, RSA_KEY_MAGIC + 3, key_data.begin());
+	key_data[3] = RSA_BINARY_VERSION;
+	key_data[4] = RSA_KEY_FLAG_MONTGOMERY | (is_private ? RSA_KEY_FLAG_PRIVATE : 0) | (has_factors ? RSA_KEY_FLAG_FACTORS : 0);
+
+	append_number(key_data, is_private ? _secret_exp : _open_exp);
+	append_number(key_data, _modulus);
+
+	if (has_factors)
+	{
+		for (const RSABigInt* factor : { &_prime_p, &_prime_q, &_exp_p, &_exp_q, &_q_inverse })
+			append_number(key_data, *factor);
+	}
+
+	std::vector<const RSAMontgomery*> contexts = { _modulus_context.get() };
+	if (has_factors)
+	{
+		contexts.push_back(_prime_p_context.get());
+		contexts.push_back(_prime_q_context.get());
+	}
+
+	for (const RSAMontgomery* context : contexts)
+	{
+		append_number(key_data, context->modulus_inverse());
+		append_number(key_data, context->r2());
+	}
+	return key_data;
+}
+
+void nrsa::RSA::_create_modulus_context()
+{
+	if (not _modulus_context or _modulus_context->modulus() != _modulus)
+		_modulus_context = std::make_shared<const RSAMontgomery>(_modulus);
+}
+
+void nrsa::RSA::_set_factors(RSABigInt p, RSABigInt q, rsa_montgomery_ptr p_context, rsa_montgomery_ptr q_context)
+{
+	if (p < q)
+	{
+		std::swap(p, q);
+		std::swap(p_context, q_context);
+	}
+
+	_prime_p = p;
+	_prime_q = q;
+	_exp_p = _secret_exp % (p - 1);
+	_exp_q = _secret_exp % (q - 1);
+	_q_inverse = _ext_gcd(q, p);
+
+	_prime_p_context = p_context ? p_context : std::make_shared<const RSAMontgomery>(p);
+	_prime_q_context = q_context ? q_context : std::make_shared<const RSAMontgomery>(q);
+}
+
+void nrsa::RSA::_clear_factors()
+{
+	_prime_p = _prime_q = _exp_p = _exp_q = _q_inverse = RSABigInt();
+	_prime_p_context.reset();
+	_prime_q_context.reset();
 }
 
 std::string nrsa::RSA::_remove_non_ascii(const std::string& source_data)
@@ -390,57 +771,328 @@ std::string nrsa::RSA::_remove_non_ascii(const std::string& source_data)
 	return ascii_string;
 }
 
-bool nrsa::RSA::_encode_data(const std::string& source_data)
+bool nrsa::RSA::_process_file(std::ifstream& fin, std::ofstream& fout, bool is_decode)
 {
-	std::vector<uint64_t> encoded_data(source_data.size());
+	// One worker splits every piece between the threads of the pool, while the next piece is read and the previous one is written
+	ncommon::Pipeline pipeline(1, 4);
 
-	for (size_t i = 0; i < source_data.size(); ++i)
-		encoded_data[i] = _pow_mod(source_data[i], _open_exp, _modulus);
+	std::string pending_data;
 
-	std::ofstream fout;
-	
-	fout.open(RSA_ENCODED_DATA_FILENAME);
-	if (not fout.is_open())
+	auto read_piece = [&](ncommon::pipeline_buffer& buffer)
+		{
+			if (not fin)
+				return false;
+
+			buffer.input.assign(pending_data);
+			buffer.input.resize(pending_data.size() + RSA_STREAM_CHUNK_SIZE);
+			fin.read(buffer.input.data() + pending_data.size(), RSA_STREAM_CHUNK_SIZE);
+			buffer.input.resize(pending_data.size() + static_cast<size_t>(fin.gcount()));
+			pending_data.clear();
+
+			buffer.is_last = not fin or fin.peek() == std::char_traits<char>::eof();
+
+			// Number cut by the end of the piece waits for the next one
+			if (is_decode and not buffer.is_last)
+			{
+				size_t separator = buffer.input.find_last_of(" \t\r\n");
+				size_t whole_size = (separator == std::string::npos) ? 0 : separator + 1;
+
+				pending_data.assign(buffer.input, whole_size);
+				buffer.input.resize(whole_size);
+			}
+			return true;
+		};
+
+	// Piece which cannot be decoded stops the writing
+	std::atomic<bool> is_decode_failed{};
+
+	auto process_piece = [&](ncommon::pipeline_buffer& buffer)
+		{
+			if (not is_decode)
+				_encode_data(_remove_non_ascii(buffer.input), buffer.output);
+			else if (not _decode_data(buffer.input, buffer.output))
+				is_decode_failed = true;
+		};
+
+	auto write_piece = [&](ncommon::pipeline_buffer& buffer)
+		{
+			if (is_decode_failed)
+				return false;
+
+			fout.write(buffer.output.data(), buffer.output.size());
+			return static_cast<bool>(fout);
+		};
+
+	if (not pipeline.run(read_piece, process_piece, write_piece))
+	{
+		if (is_decode_failed)
+			std::cout << "Encoded data does not fit the key!\n" << std::endl;
+		else
+			std::cout << "Cannot write the " << (is_decode ? "decoded" : "encoded") << " data!\n" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool nrsa::RSA::_decode_binary_file(const ncommon::MappedFile& fin, std::ofstream& fout)
+{
+	// Magic is checked already, values must have the limbs of the modulus
+	size_t limbs_count = (fin.size() >= RSA_BINARY_HEADER_SIZE) ? read_uint32(fin.data() + 4) : 0;
+	size_t value_size = 8 * limbs_count;
+
+	if (not limbs_count or fin.data()[3] != RSA_BINARY_VERSION or limbs_count != _modulus.limbs_count()
+		or (fin.size() - RSA_BINARY_HEADER_SIZE) % value_size != 0)
 	{
-		std::cout << "Cannot open file [" << RSA_ENCODED_DATA_FILENAME << "] to write!\n" << std::endl;
+		std::cout << "Encoded data does not fit the key!\n" << std::endl;
+		return false;
+	}
+
+	const char* values = fin.data() + RSA_BINARY_HEADER_SIZE;
+	size_t values_count = (fin.size() - RSA_BINARY_HEADER_SIZE) / value_size;
+
+	ncommon::Pipeline pipeline(1, 4);
+
+	// Piece which cannot be decoded stops the writing
+	std::atomic<bool> is_decode_failed{};
+
+	// Reader only hands out the ranges of the values
+	size_t next_value{};
+	bool is_read_all = false;
+
+	auto read_piece = [&](ncommon::pipeline_buffer& buffer)
+		{
+			if (is_read_all)
+				return false;
+
+			buffer.context = next_value;
+			next_value = std::min(next_value + RSA_BINARY_PIECE_VALUES, values_count);
+			buffer.is_last = is_read_all = (next_value == values_count);
+			return true;
+		};
+
+	auto process_piece = [&](ncommon::pipeline_buffer& buffer)
+		{
+			size_t first_value = static_cast<size_t>(buffer.context);
+			size_t piece_values = std::min(RSA_BINARY_PIECE_VALUES, values_count - first_value);
+
+			const char* piece = values + first_value * value_size;
+
+			bool is_decoded = _process_values(piece_values, buffer.output, [this, piece, value_size, limbs_count](size_t first, size_t last, std::string& output)
+				{
+					std::string block(_get_block_size(), '\0');
+
+					for (size_t i = first; i < last; ++i)
+						if (not _decode_value(RSABigInt::from_little_endian(piece + i * value_size, limbs_count), block, output))
+							return false;
+					return true;
+				}
+			);
+
+			if (not is_decoded)
+				is_decode_failed = true;
+		};
 
-		for (size_t i = 0; i < source_data.size(); ++i)
-			std::cout << encoded_data[i] << " ";
-		std::cout << std::endl;
+	auto write_piece = [&](ncommon::pipeline_buffer& buffer)
+		{
+			if (is_decode_failed)
+				return false;
+
+			fout.write(buffer.output.data(), buffer.output.size());
+			return static_cast<bool>(fout);
+		};
+
+	if (not pipeline.run(read_piece, process_piece, write_piece))
+	{
+		if (is_decode_failed)
+			std::cout << "Encoded data does not fit the key!\n" << std::endl;
+		else
+			std::cout << "Cannot write the decoded data!\n" << std::endl;
 		return false;
 	}
-	std::copy(encoded_data.begin(), encoded_data.end(), std::ostream_iterator<uint64_t>(fout, " "));
-	fout.close();
+	return true;
+}
 
-	std::cout << "Source data was encoded and written to file [" << RSA_ENCODED_DATA_FILENAME << "].\n" << std::endl;
+size_t nrsa::RSA::_get_threads_count()
+{
+	return _threads_count ? _threads_count : std::max<size_t>(std::thread::hardware_concurrency(), 1);
 }
 
-bool nrsa::RSA::_decode_data(const std::string& encoded_data)
+ncommon::ThreadPool& nrsa::RSA::_get_thread_pool()
 {
-	std::stringstream ss(encoded_data);
-	std::istream_iterator<std::string> begin(ss);
-	std::istream_iterator<std::string> end;
+	size_t threads_count = _get_threads_count();
 
-	std::vector<std::string> _encoded_data(begin, end);
-	std::string decoded_data;
+	if (not _thread_pool or _thread_pool->size() != threads_count)
+		_thread_pool = std::make_shared<ncommon::ThreadPool>(threads_count);
+	return *_thread_pool;
+}
 
-	decoded_data.reserve(_encoded_data.size());
-	for (auto& encoded_symbol : _encoded_data)
-		decoded_data += static_cast<char>(_pow_mod(std::stoull(encoded_symbol), _secret_exp, _modulus));
+bool nrsa::RSA::_process_values(size_t values_count, std::string& output, const std::function<bool(size_t first, size_t last, std::string& output)>& process)
+{
+	output.clear();
+	if (values_count == 0)
+		return true;
 
-	std::ofstream fout;
+	ncommon::ThreadPool& thread_pool = _get_thread_pool();
 
-	fout.open(RSA_DECODED_DATA_FILENAME);
-	if (not fout.is_open())
+	// Every value is a whole exponentiation, so a few values are enough for a task
+	size_t task_values = (values_count + RSA_TASKS_PER_THREAD * thread_pool.size() - 1) / (RSA_TASKS_PER_THREAD * thread_pool.size());
+	size_t tasks_count = (values_count + task_values - 1) / task_values;
+
+	if (_task_outputs.size() < tasks_count)
+		_task_outputs.resize(tasks_count);
+
+	std::atomic<bool> is_failed{};
+
+	thread_pool.parallel_for(tasks_count, [this, values_count, task_values, &process, &is_failed](size_t task)
+		{
+			size_t first = task * task_values;
+
+			_task_outputs[task].clear();
+			if (not process(first, std::min(first + task_values, values_count), _task_outputs[task]))
+				is_failed = true;
+		}
+	);
+
+	if (is_failed)
+		return false;
+
+	size_t output_size{};
+	for (size_t task = 0; task < tasks_count; ++task)
+		output_size += _task_outputs[task].size();
+
+	output.reserve(output_size);
+	for (size_t task = 0; task < tasks_count; ++task)
+		output += _task_outputs[task];
+	return true;
+}
+
+void nrsa::RSA::_encode_data(const std::string& source_data, std::string& encoded_data)
+{
+	size_t block_size = _get_block_size();
+	if (block_size <= RSA_PADDING_SIZE)
 	{
-		std::cout << "Cannot open file [" << RSA_DECODED_DATA_FILENAME << "] to write!\n" << std::endl;
+		_process_values(source_data.size(), encoded_data, [this, &source_data](size_t first, size_t last, std::string& output)
+			{
+				for (size_t i = first; i < last; ++i)
+					_append_value(_pow_mod(static_cast<uint8_t>(source_data[i]), _open_exp, *_modulus_context), output);
+				return true;
+			}
+		);
+		return;
+	}
+
+	// Every number of the random device gives 4 padding bytes, the zero bytes are dropped
+	std::random_device padding_random;
+	uint32_t random_bytes{};
+	size_t random_bytes_count{};
+
+	auto nonzero_byte = [&padding_random, &random_bytes, &random_bytes_count]()
+		{
+			while (true)
+			{
+				if (not random_bytes_count)
+				{
+					random_bytes = padding_random();
+					random_bytes_count = 4;
+				}
+
+				char byte = static_cast<char>(random_bytes & 0xFF);
+				random_bytes >>= 8;
+				--random_bytes_count;
+
+				if (byte)
+					return byte;
+			}
+		};
+
+	size_t block_data_size = block_size - RSA_PADDING_SIZE;
+	size_t blocks_count = (source_data.size() + block_data_size - 1) / block_data_size;
+
+	// Padding bytes are drawn by one thread, the random device may not be shared by the threads
+	std::string blocks(blocks_count * block_size, '\0');
+	for (size_t position = 0; position < source_data.size(); position += block_data_size)
+	{
+		char* block = blocks.data() + position / block_data_size * block_size;
+		size_t data_size = std::min(block_data_size, source_data.size() - position);
+		size_t random_size = block_size - 3 - data_size;
+
+		block[0] = 0;
+		block[1] = 2;
+		for (size_t i = 0; i < random_size; ++i)
+			block[2 + i] = nonzero_byte();
+		block[2 + random_size] = 0;
+		source_data.copy(block + 3 + random_size, data_size, position);
+	}
+
+	_process_values(blocks_count, encoded_data, [this, &blocks, block_size](size_t first, size_t last, std::string& output)
+		{
+			for (size_t i = first; i < last; ++i)
+				_append_value(_pow_mod(RSABigInt::from_bytes(blocks.data() + i * block_size, block_size), _open_exp, *_modulus_context), output);
+			return true;
+		}
+	);
+}
+
+bool nrsa::RSA::_decode_data(const std::string& encoded_data, std::string& decoded_data)
+{
+	// Numbers are found first, then parsed and decoded by the threads
+	RSADecimalScanner scanner(encoded_data.data(), encoded_data.size());
+	std::vector<std::string_view> numbers;
+
+	std::string_view token;
+	while (scanner.next(token))
+		numbers.push_back(token);
+
+	return _process_values(numbers.size(), decoded_data, [this, &numbers](size_t first, size_t last, std::string& output)
+		{
+			std::string block(_get_block_size(), '\0');
+			RSABigInt symbol;
+
+			for (size_t i = first; i < last; ++i)
+				if (not RSABigInt::from_string(numbers[i], symbol) or not _decode_value(symbol, block, output))
+					return false;
+			return true;
+		}
+	);
+}
 
-		std::cout << decoded_data << "\n" << std::endl;
+bool nrsa::RSA::_decode_value(const RSABigInt& value, std::string& block, std::string& decoded_data)
+{
+	if (value >= _modulus)
 		return false;
+
+	RSABigInt decoded_value = _private_pow_mod(value);
+	if (block.size() <= RSA_PADDING_SIZE)
+	{
+		if (decoded_value.limbs_count() > 1 or decoded_value.low_limb() > 0xFF)
+			return false;
+
+		decoded_data += static_cast<char>(decoded_value.low_limb());
+		return true;
 	}
-	fout << decoded_data;
-	fout.close();
 
-	std::cout << "Encoded data was decoded and written to file [" << RSA_DECODED_DATA_FILENAME << "].\n" << std::endl;
+	if (not decoded_value.to_bytes(block.data(), block.size()))
+		return false;
+
+	// Data goes after the first zero byte behind the random bytes
+	size_t separator = block.find('\0', 2);
+	if (block[0] != 0 or block[1] != 2 or separator == std::string::npos or separator < 2 + RSA_PADDING_MIN_RANDOM_SIZE)
+		return false;
+
+	decoded_data.append(block, separator + 1, std::string::npos);
 	return true;
 }
+
+void nrsa::RSA::_append_value(const RSABigInt& value, std::string& encoded_data)
+{
+	if (not _is_binary)
+	{
+		value.append_to_string(encoded_data);
+		encoded_data += ' ';
+		return;
+	}
+
+	size_t position = encoded_data.size();
+	encoded_data.resize(position + 8 * _modulus.limbs_count());
+	value.to_little_endian(encoded_data.data() + position, _modulus.limbs_count());
+}
@@ -1,6 +1,20 @@
 #pragma once
 
+#include <cstdint>
+
+#include <fstream>
+#include <functional>
+#include <memory>
 #include <random>
+#include <string>
+#include <vector>
+
+#include "../common/MappedFile.hpp"
+#include "../common/Pipeline.hpp"
+#include "../common/ThreadPool.hpp"
+
+#include "RSABigInt.hpp"
+#include "RSAMontgomery.hpp"
 
 namespace nrsa
 {
@@ -10,6 +24,58 @@ namespace nrsa
 	const char* const RSA_ENCODED_DATA_FILENAME = "encoded_data.txt";
 	const char* const RSA_DECODED_DATA_FILENAME = "decoded_data.txt";
 
+	const char* const RSA_PUBLIC_KEY_BINARY_FILENAME = "key_pub.bin";
+	const char* const RSA_PRIVATE_KEY_BINARY_FILENAME = "key.bin";
+	const char* const RSA_ENCODED_BINARY_FILENAME = "encoded_data.bin";
+
+	// Binary files: magic, version and 4 bytes of the header, then little endian numbers.
+	// Key has the flags and its numbers as a count of limbs (4 bytes) with the limbs,
+	// data has the count of limbs of every value (4 bytes) and the values of this size
+	const char* const RSA_KEY_MAGIC = "RSK";
+	const char* const RSA_DATA_MAGIC = "RSD";
+	constexpr char RSA_BINARY_VERSION = 1;
+	constexpr size_t RSA_BINARY_HEADER_SIZE = 8;
+
+	// Private key has p, q, dP, dQ and qInv after the exponent and the modulus
+	constexpr char RSA_KEY_FLAG_PRIVATE = 1;
+	constexpr char RSA_KEY_FLAG_FACTORS = 2;
+
+	// Key ends by -m^-1 mod 2^64 and R^2 mod m of the Montgomery form for the modulus, then for p and q
+	constexpr char RSA_KEY_FLAG_MONTGOMERY = 4;
+
+	// Values of the binary data read at once, the values of a piece are decoded by all the threads
+	constexpr size_t RSA_BINARY_PIECE_VALUES = 1024;
+
+	// Values of a piece are split into this many tasks for every thread, so the faster threads take the rest
+	constexpr size_t RSA_TASKS_PER_THREAD = 4;
+
+	// Bytes of the source data read at once, every piece goes through the pipeline on its own
+	constexpr size_t RSA_STREAM_CHUNK_SIZE = 1 << 16;
+
+	// Bits of the modulus, every prime has a half of them
+	constexpr size_t RSA_DEFAULT_KEY_SIZE = 2048;
+	constexpr size_t RSA_MIN_KEY_SIZE = 64;
+
+	constexpr uint64_t RSA_OPEN_EXP = 65537;
+
+	// Candidates to the primes are divided by the primes below it before Miller-Rabin
+	constexpr uint64_t RSA_SMALL_PRIMES_LIMIT = 2048;
+
+	// Blocks of the modulus bytes are padded as in PKCS #1 v1.5: 00 02, at least 8 random nonzero bytes, 00, data.
+	// Modulus too short for the padding encodes every symbol as a value of its own
+	constexpr size_t RSA_PADDING_MIN_RANDOM_SIZE = 8;
+	constexpr size_t RSA_PADDING_SIZE = RSA_PADDING_MIN_RANDOM_SIZE + 3;
+
+
+	// Numbers of a key file, the factors and the contexts of the modulus, p and q can be absent
+	struct rsa_key
+	{
+		RSABigInt exp;
+		RSABigInt modulus;
+		std::vector<RSABigInt> factors;
+		rsa_montgomery_ptr contexts[3];
+	};
+
 
 	class RSA
 	{
@@ -18,54 +84,133 @@ namespace nrsa
 		RSA(uint64_t seed);
 
 		void set_seed(uint64_t seed) { _seed = seed; _mt64.seed(seed); }
-		
+
+		// 0 threads means one thread per core
+		void set_threads_count(size_t threads_count) { _threads_count = threads_count; }
+
+		// Used by the next generate_keys, 2048, 3072 and 4096 bits are the usual ones
+		bool set_key_size(size_t key_size);
+
+		// Keys and encoded data are saved in the binary files, loading and decoding find the format by themselves
+		void set_binary(bool is_binary) { _is_binary = is_binary; }
+
 		void generate_keys();
 		void show_keys();
 		bool save_keys(const char* filename = "key");
-		bool load_keys(const char* filename_pub = RSA_PUBLIC_KEY_FILENAME, const char* filename_priv = RSA_PRIVATE_KEY_FILENAME);
+
+		// Files of the current format by default
+		bool load_keys(const char* filename_pub = nullptr, const char* filename_priv = nullptr);
 
 		bool is_prime_num(uint64_t val);
+		bool is_prime_num(const RSABigInt& val);
 
 		bool encode(const char* filename);
-		bool decode(const char* filename = RSA_ENCODED_DATA_FILENAME);
+		bool decode(const char* filename = nullptr);
 
 	private:
 		void _init();
-		uint64_t _get_prime_num(uint64_t _mod = 65536);
+		RSABigInt _get_prime_num(size_t bits);
 		
 		bool _miller_rabin_prime(uint64_t val, int16_t iterations = 5);
+		bool _miller_rabin_prime(const RSABigInt& val, int16_t iterations = 5);
 		
 		uint64_t _pow_mod(uint64_t base, uint64_t exp, uint64_t modulus);
-		uint64_t _multiply_mod1(uint64_t val1, uint64_t val2, uint64_t modulus);
-		uint64_t _multiply_mod2(uint64_t val1, uint64_t val2, uint64_t modulus);
-		uint64_t _add_mod(uint64_t val1, uint64_t val2, uint64_t modulus);
+		RSABigInt _pow_mod(const RSABigInt& base, const RSABigInt& exp, const RSAMontgomery& modulus);
+
+		// val^d mod n, by the Chinese remainder theorem when the factors of the modulus are known
+		RSABigInt _private_pow_mod(const RSABigInt& val);
+		uint64_t _multiply_mod(uint64_t val1, uint64_t val2, uint64_t modulus);
 
 		uint64_t _rand();
 		uint64_t _rand(uint64_t _left, uint64_t _right);
+		RSABigInt _rand(const RSABigInt& _left, const RSABigInt& _right);
 
-		uint64_t _calc_e(uint64_t totient, uint64_t p, uint64_t q);
-		uint64_t _calc_d(uint64_t totient, uint64_t e);
+		// Random number below 2^bits
+		RSABigInt _rand_bits(size_t bits);
 
-		uint64_t _gcd(uint64_t a, uint64_t b);
-		uint64_t _ext_gcd(uint64_t u, uint64_t v);
+		// Zero, when the open exponent is not coprime with the totient
+		RSABigInt _calc_e(const RSABigInt& totient);
+		RSABigInt _calc_d(const RSABigInt& totient, const RSABigInt& e);
+
+		RSABigInt _gcd(RSABigInt a, RSABigInt b);
+		RSABigInt _ext_gcd(const RSABigInt& u, const RSABigInt& v);
+
+		static const std::vector<uint64_t>& _get_small_primes();
+		static std::vector<uint64_t> _create_small_primes();
 
 	private:
 		bool _save_key(std::string filename, bool is_private);
 		bool _load_key(const std::string& filename, bool is_private);
 
-		bool _read_file_data(const std::string& filename, std::string& read_data, bool is_decode = false);
+		void _create_modulus_context();
+
+		// Exponents by p - 1 and q - 1 and q^-1 mod p from the secret exponent, p becomes the greater factor
+		void _set_factors(RSABigInt p, RSABigInt q, rsa_montgomery_ptr p_context = nullptr, rsa_montgomery_ptr q_context = nullptr);
+		void _clear_factors();
+
+		// Text key is the numbers in decimal separated by spaces
+		bool _read_text_key(const std::string& key_data, bool is_private, rsa_key& key);
+		bool _read_binary_key(const std::string& key_data, bool is_private, rsa_key& key);
+		std::string _write_binary_key(bool is_private);
+
 		std::string _remove_non_ascii(const std::string& source_data);
 
-		bool _encode_data(const std::string& source_data);
-		bool _decode_data(const std::string& encoded_data);
+		// Reading, encoding and writing of the pieces run in a pipeline at the same time
+		bool _process_file(std::ifstream& fin, std::ofstream& fout, bool is_decode);
+
+		// Values are taken by the threads right from the mapped file
+		bool _decode_binary_file(const ncommon::MappedFile& fin, std::ofstream& fout);
+
+		size_t _get_threads_count();
+		ncommon::ThreadPool& _get_thread_pool();
+
+		// Values [0, values_count) are split between the threads, every task appends [first, last) to its own output,
+		// then the outputs are joined in order. False when any task returns false
+		bool _process_values(size_t values_count, std::string& output, const std::function<bool(size_t first, size_t last, std::string& output)>& process);
+
+		// Bytes of the modulus, every value of the encoded data is one block of them
+		size_t _get_block_size() const { return (_modulus.bits_count() + 7) / 8; }
+
+		// Random padding bytes come from the random device, they are taken before the blocks are encoded by the threads
+		void _encode_data(const std::string& source_data, std::string& encoded_data);
+
+		// False on a token which is not a number, a value not less than the modulus or a block with a wrong padding
+		bool _decode_data(const std::string& encoded_data, std::string& decoded_data);
+		bool _decode_value(const RSABigInt& value, std::string& block, std::string& decoded_data);
+
+		// Decimal and a space or the limbs of the modulus size
+		void _append_value(const RSABigInt& value, std::string& encoded_data);
 
 	private:
-		uint64_t _modulus{};
-		uint64_t _open_exp{};
-		uint64_t _secret_exp{};
+		RSABigInt _modulus;
+		RSABigInt _open_exp;
+		RSABigInt _secret_exp;
+
+		// Montgomery form of the modulus, shared by the threads
+		rsa_montgomery_ptr _modulus_context;
+
+		// Private key for the Chinese remainder theorem: p > q, d mod (p - 1), d mod (q - 1) and q^-1 mod p,
+		// the contexts are empty for a key without them
+		RSABigInt _prime_p;
+		RSABigInt _prime_q;
+		RSABigInt _exp_p;
+		RSABigInt _exp_q;
+		RSABigInt _q_inverse;
+
+		rsa_montgomery_ptr _prime_p_context;
+		rsa_montgomery_ptr _prime_q_context;
+
+		size_t _key_size{ RSA_DEFAULT_KEY_SIZE };
+		bool _is_binary{};
 
 	private:
 		uint64_t _seed{};
 		std::mt19937_64 _mt64;
+
+		size_t _threads_count{};
+		std::shared_ptr<ncommon::ThreadPool> _thread_pool;
+
+		// Output of every task, kept between the pieces
+		std::vector<std::string> _task_outputs;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,545 @@
+#include "RSABigInt.hpp"
+#include "RSADecimal.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	// Largest power of ten in one limb, decimal text goes by 19 digits
+	constexpr uint64_t DECIMAL_CHUNK = 10000000000000000000ull;
+}
+
+nrsa::RSABigInt::RSABigInt(uint64_t value)
+{
+	if (value)
+		_limbs.push_back(value);
+}
+
+bool nrsa::RSABigInt::from_string(std::string_view decimal, RSABigInt& value)
+{
+	if (decimal.empty())
+		return false;
+
+	for (char symbol : decimal)
+		if (symbol < '0' or symbol > '9')
+			return false;
+
+	// Memory of the value is used again
+	value._limbs.clear();
+
+	// First chunk is shorter, so all the next ones have 19 digits
+	size_t chunk_size = decimal.size() % RSA_DECIMAL_LIMB_DIGITS;
+	if (not chunk_size)
+		chunk_size = RSA_DECIMAL_LIMB_DIGITS;
+
+	for (size_t position = 0; position < decimal.size(); position += chunk_size, chunk_size = RSA_DECIMAL_LIMB_DIGITS)
+	{
+		uint64_t chunk = parse_decimal(decimal.data() + position, chunk_size);
+
+		uint64_t multiplier{ 1 };
+		for (size_t i = 0; i < chunk_size; ++i)
+			multiplier *= 10;
+
+		// value = value * 10^chunk_size + chunk
+		limb_type carry = chunk;
+		for (auto& limb : value._limbs)
+			limb = multiply_add(limb, multiplier, carry, 0, carry);
+
+		if (carry)
+			value._limbs.push_back(carry);
+	}
+	return true;
+}
+
+std::string nrsa::RSABigInt::to_string() const
+{
+	std::string decimal;
+	append_to_string(decimal);
+	return decimal;
+}
+
+void nrsa::RSABigInt::append_to_string(std::string& text) const
+{
+	if (_limbs.size() <= 1)
+	{
+		char digits[RSA_DECIMAL_MAX_DIGITS];
+		text.append(format_decimal(low_limb(), digits + RSA_DECIMAL_MAX_DIGITS), digits + RSA_DECIMAL_MAX_DIGITS);
+		return;
+	}
+
+	// Chunks of 19 digits from the least significant one go to the end of the space of 20 digits for every limb
+	size_t position = text.size();
+	text.resize(position + RSA_DECIMAL_MAX_DIGITS * _limbs.size());
+
+	char* end = text.data() + text.size();
+	char* begin = end;
+
+	RSABigInt value(*this);
+	while (not value.is_zero())
+	{
+		uint64_t chunk = value.divide_small(DECIMAL_CHUNK);
+		begin = format_decimal(chunk, begin, value.is_zero() ? 1 : RSA_DECIMAL_LIMB_DIGITS);
+	}
+
+	size_t size = static_cast<size_t>(end - begin);
+	std::memmove(text.data() + position, begin, size);
+	text.resize(position + size);
+}
+
+nrsa::RSABigInt nrsa::RSABigInt::from_limbs(const limb_type* limbs, size_t limbs_count)
+{
+	RSABigInt value;
+	value._limbs.assign(limbs, limbs + limbs_count);
+	value._normalize();
+	return value;
+}
+
+nrsa::RSABigInt nrsa::RSABigInt::from_bytes(const char* bytes, size_t size)
+{
+	RSABigInt value;
+	value._limbs.assign((size + 7) / 8, 0);
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		size_t position = size - 1 - i;
+		value._limbs[i / 8] |= static_cast<limb_type>(static_cast<uint8_t>(bytes[position])) << (8 * (i % 8));
+	}
+
+	value._normalize();
+	return value;
+}
+
+bool nrsa::RSABigInt::to_bytes(char* bytes, size_t size) const
+{
+	if (bits_count() > 8 * size)
+		return false;
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		limb_type limb = (i / 8 < _limbs.size()) ? _limbs[i / 8] : 0;
+		bytes[size - 1 - i] = static_cast<char>(limb >> (8 * (i % 8)));
+	}
+	return true;
+}
+
+nrsa::RSABigInt nrsa::RSABigInt::from_little_endian(const char* bytes, size_t limbs_count)
+{
+	RSABigInt value;
+	value._limbs.assign(limbs_count, 0);
+
+	for (size_t i = 0; i < 8 * limbs_count; ++i)
+		value._limbs[i / 8] |= static_cast<limb_type>(static_cast<uint8_t>(bytes[i])) << (8 * (i % 8));
+
+	value._normalize();
+	return value;
+}
+
+bool nrsa::RSABigInt::to_little_endian(char* bytes, size_t limbs_count) const
+{
+	if (_limbs.size() > limbs_count)
+		return false;
+
+	for (size_t i = 0; i < 8 * limbs_count; ++i)
+	{
+		limb_type limb = (i / 8 < _limbs.size()) ? _limbs[i / 8] : 0;
+		bytes[i] = static_cast<char>(limb >> (8 * (i % 8)));
+	}
+	return true;
+}
+
+size_t nrsa::RSABigInt::bits_count() const
+{
+	if (is_zero())
+		return 0;
+
+	size_t bits = 64 * _limbs.size();
+	for (limb_type top = _limbs.back(); not (top >> 63); top <<= 1)
+		--bits;
+	return bits;
+}
+
+bool nrsa::RSABigInt::bit(size_t index) const
+{
+	return index / 64 < _limbs.size() and ((_limbs[index / 64] >> (index % 64)) & 1);
+}
+
+void nrsa::RSABigInt::set_bit(size_t index)
+{
+	if (index / 64 >= _limbs.size())
+		_limbs.resize(index / 64 + 1, 0);
+	_limbs[index / 64] |= limb_type{ 1 } << (index % 64);
+}
+
+int nrsa::RSABigInt::compare(const RSABigInt& other) const
+{
+	if (_limbs.size() != other._limbs.size())
+		return (_limbs.size() < other._limbs.size()) ? -1 : 1;
+
+	for (size_t i = _limbs.size(); i-- > 0;)
+		if (_limbs[i] != other._limbs[i])
+			return (_limbs[i] < other._limbs[i]) ? -1 : 1;
+	return 0;
+}
+
+nrsa::RSABigInt& nrsa::RSABigInt::operator+=(const RSABigInt& other)
+{
+	if (_limbs.size() < other._limbs.size())
+		_limbs.resize(other._limbs.size(), 0);
+
+	limb_type carry = add_limbs(_limbs.data(), other._limbs.data(), other._limbs.size());
+	carry = _add_carry(_limbs.data() + other._limbs.size(), _limbs.size() - other._limbs.size(), carry);
+
+	if (carry)
+		_limbs.push_back(carry);
+	return *this;
+}
+
+nrsa::RSABigInt& nrsa::RSABigInt::operator-=(const RSABigInt& other)
+{
+	limb_type borrow = subtract_limbs(_limbs.data(), other._limbs.data(), other._limbs.size());
+	_subtract_borrow(_limbs.data() + other._limbs.size(), _limbs.size() - other._limbs.size(), borrow);
+
+	_normalize();
+	return *this;
+}
+
+nrsa::RSABigInt& nrsa::RSABigInt::operator*=(const RSABigInt& other)
+{
+	if (is_zero() or other.is_zero())
+	{
+		_limbs.clear();
+		return *this;
+	}
+
+	std::vector<limb_type> result(_limbs.size() + other._limbs.size());
+
+	// Karatsuba needs operands of the same size
+	if (_limbs.size() == other._limbs.size() and _limbs.size() >= RSA_KARATSUBA_THRESHOLD)
+	{
+		std::vector<limb_type> scratch(multiply_scratch_size(_limbs.size()));
+		multiply(_limbs.data(), other._limbs.data(), _limbs.size(), result.data(), scratch.data());
+	}
+	else
+		multiply_schoolbook(_limbs.data(), _limbs.size(), other._limbs.data(), other._limbs.size(), result.data());
+
+	_limbs.swap(result);
+	_normalize();
+	return *this;
+}
+
+nrsa::RSABigInt& nrsa::RSABigInt::operator<<=(size_t shift)
+{
+	if (is_zero())
+		return *this;
+
+	size_t limbs_shift = shift / 64, bits_shift = shift % 64;
+	_limbs.insert(_limbs.begin(), limbs_shift, 0);
+
+	if (bits_shift)
+	{
+		_limbs.push_back(0);
+		for (size_t i = _limbs.size() - 1; i > limbs_shift; --i)
+			_limbs[i] = (_limbs[i] << bits_shift) | (_limbs[i - 1] >> (64 - bits_shift));
+		_limbs[limbs_shift] <<= bits_shift;
+	}
+
+	_normalize();
+	return *this;
+}
+
+nrsa::RSABigInt& nrsa::RSABigInt::operator>>=(size_t shift)
+{
+	size_t limbs_shift = shift / 64, bits_shift = shift % 64;
+	if (limbs_shift >= _limbs.size())
+	{
+		_limbs.clear();
+		return *this;
+	}
+
+	_limbs.erase(_limbs.begin(), _limbs.begin() + limbs_shift);
+
+	if (bits_shift)
+	{
+		for (size_t i = 0; i + 1 < _limbs.size(); ++i)
+			_limbs[i] = (_limbs[i] >> bits_shift) | (_limbs[i + 1] << (64 - bits_shift));
+		_limbs.back() >>= bits_shift;
+	}
+
+	_normalize();
+	return *this;
+}
+
+void nrsa::RSABigInt::divide(const RSABigInt& dividend, const RSABigInt& divisor, RSABigInt& quotient, RSABigInt& remainder)
+{
+	if (dividend < divisor)
+	{
+		remainder = dividend;
+		quotient = RSABigInt();
+		return;
+	}
+
+	if (divisor._limbs.size() == 1)
+	{
+		quotient = dividend;
+		remainder = RSABigInt(quotient.divide_small(divisor._limbs[0]));
+		return;
+	}
+
+	// Knuth, algorithm D: the top bit of the divisor is set, so every estimated quotient limb is at most 2 too large
+	size_t shift{};
+	for (limb_type top = divisor._limbs.back(); not (top >> 63); top <<= 1)
+		++shift;
+
+	RSABigInt u = dividend << shift;
+	RSABigInt v = divisor << shift;
+	u._limbs.push_back(0);
+
+	size_t n = v._limbs.size(), m = u._limbs.size() - n - 1;
+	const limb_type* vl = v._limbs.data();
+	limb_type* ul = u._limbs.data();
+
+	quotient._limbs.assign(m + 1, 0);
+
+	for (size_t j = m + 1; j-- > 0;)
+	{
+		// Top limb of the rest is never above the top limb of the divisor, when they are equal the estimate is cut to one limb
+		limb_type qhat{}, rhat{};
+		bool is_rhat_overflow = false;
+		if (ul[j + n] == vl[n - 1])
+		{
+			qhat = ~limb_type{};
+			rhat = ul[j + n - 1] + vl[n - 1];
+			is_rhat_overflow = rhat < vl[n - 1];
+		}
+		else
+			qhat = divide_wide(ul[j + n], ul[j + n - 1], vl[n - 1], rhat);
+
+		// qhat * v[n - 2] > rhat:u[j + n - 2], it cannot be when rhat has more than one limb
+		while (not is_rhat_overflow)
+		{
+			limb_type product_high{};
+			limb_type product_low = multiply_wide(qhat, vl[n - 2], product_high);
+			if (product_high < rhat or (product_high == rhat and product_low <= ul[j + n - 2]))
+				break;
+
+			--qhat;
+			rhat += vl[n - 1];
+			is_rhat_overflow = rhat < vl[n - 1];
+		}
+
+		// u[j..j + n] -= qhat * v
+		limb_type q = qhat, carry{}, borrow{};
+		for (size_t i = 0; i < n; ++i)
+		{
+			limb_type product = multiply_add(q, vl[i], carry, 0, carry);
+			limb_type difference = ul[i + j] - product - borrow;
+			borrow = (ul[i + j] < product) or (ul[i + j] - product < borrow);
+			ul[i + j] = difference;
+		}
+		limb_type top = ul[j + n];
+		ul[j + n] = top - carry - borrow;
+
+		// Estimate was one too large
+		if (top < carry or top - carry < borrow)
+		{
+			--q;
+			ul[j + n] += add_limbs(ul + j, vl, n);
+		}
+		quotient._limbs[j] = q;
+	}
+
+	quotient._normalize();
+	u._normalize();
+	remainder = u >> shift;
+}
+
+uint64_t nrsa::RSABigInt::divide_small(uint64_t divisor)
+{
+	limb_type remainder{};
+	for (size_t i = _limbs.size(); i-- > 0;)
+		_limbs[i] = divide_wide(remainder, _limbs[i], divisor, remainder);
+
+	_normalize();
+	return remainder;
+}
+
+uint64_t nrsa::RSABigInt::mod_small(uint64_t divisor) const
+{
+	limb_type remainder{};
+	for (size_t i = _limbs.size(); i-- > 0;)
+		divide_wide(remainder, _limbs[i], divisor, remainder);
+	return remainder;
+}
+
+void nrsa::RSABigInt::multiply(const limb_type* a, const limb_type* b, size_t count, limb_type* result, limb_type* scratch)
+{
+	// Squares need about a half of the products, all the parts of a square are squares too
+	bool is_square = (a == b);
+
+	if (count < RSA_KARATSUBA_THRESHOLD)
+	{
+		if (is_square)
+			_square_schoolbook(a, count, result);
+		else
+			multiply_schoolbook(a, count, b, count, result);
+		return;
+	}
+
+	// a = a1 * B^low + a0, a * b = z2 * B^2low + z1 * B^low + z0, z1 = (a0 + a1)(b0 + b1) - z0 - z2
+	size_t low = count / 2, high = count - low;
+
+	limb_type* a_sum = scratch;
+	limb_type* b_sum = a_sum + high;
+	limb_type* middle = b_sum + high;
+	limb_type* next_scratch = middle + 2 * high + 2;
+
+	multiply(a, b, low, result, next_scratch);
+	multiply(a + low, b + low, high, result + 2 * low, next_scratch);
+
+	// Sums have high limbs and a carry
+	std::copy(a + low, a + count, a_sum);
+	limb_type a_carry = add_limbs(a_sum, a, low);
+	a_carry = _add_carry(a_sum + low, high - low, a_carry);
+
+	limb_type b_carry = a_carry;
+	if (is_square)
+		b_sum = a_sum;
+	else
+	{
+		std::copy(b + low, b + count, b_sum);
+		b_carry = add_limbs(b_sum, b, low);
+		b_carry = _add_carry(b_sum + low, high - low, b_carry);
+	}
+
+	multiply(a_sum, b_sum, high, middle, next_scratch);
+	middle[2 * high] = 0;
+	middle[2 * high + 1] = 0;
+
+	if (a_carry)
+		_add_carry(middle + 2 * high, 2, add_limbs(middle + high, b_sum, high));
+	if (b_carry)
+		_add_carry(middle + 2 * high, 2, add_limbs(middle + high, a_sum, high));
+	if (a_carry and b_carry)
+		_add_carry(middle + 2 * high, 2, 1);
+
+	_subtract_borrow(middle + 2 * low, 2 * (high - low) + 2, subtract_limbs(middle, result, 2 * low));
+	_subtract_borrow(middle + 2 * high, 2, subtract_limbs(middle, result + 2 * low, 2 * high));
+
+	// Top limbs of the middle part are zeros, when they go past the result
+	size_t middle_count = std::min(2 * high + 2, 2 * count - low);
+	_add_carry(result + low + middle_count, 2 * count - low - middle_count, add_limbs(result + low, middle, middle_count));
+}
+
+size_t nrsa::RSABigInt::multiply_scratch_size(size_t count)
+{
+	if (count < RSA_KARATSUBA_THRESHOLD)
+		return 0;
+
+	size_t high = count - count / 2;
+	return 4 * high + 2 + multiply_scratch_size(high);
+}
+
+void nrsa::RSABigInt::multiply_schoolbook(const limb_type* a, size_t a_count, const limb_type* b, size_t b_count, limb_type* result)
+{
+	std::fill(result, result + a_count + b_count, 0);
+
+	for (size_t i = 0; i < a_count; ++i)
+	{
+		limb_type carry{};
+		for (size_t j = 0; j < b_count; ++j)
+			result[i + j] = multiply_add(a[i], b[j], result[i + j], carry, carry);
+		result[i + b_count] = carry;
+	}
+}
+
+void nrsa::RSABigInt::_square_schoolbook(const limb_type* a, size_t count, limb_type* result)
+{
+	std::fill(result, result + 2 * count, 0);
+
+	// Products of the different limbs are met twice, so they are summed once and doubled
+	for (size_t i = 0; i < count; ++i)
+	{
+		limb_type carry{};
+		for (size_t j = i + 1; j < count; ++j)
+			result[i + j] = multiply_add(a[i], a[j], result[i + j], carry, carry);
+		result[i + count] = carry;
+	}
+
+	limb_type top{};
+	for (size_t i = 0; i < 2 * count; ++i)
+	{
+		limb_type next_top = result[i] >> 63;
+		result[i] = (result[i] << 1) | top;
+		top = next_top;
+	}
+
+	limb_type carry{};
+	for (size_t i = 0; i < count; ++i)
+	{
+		limb_type high{};
+		result[2 * i] = multiply_add(a[i], a[i], result[2 * i], carry, high);
+		result[2 * i + 1] += high;
+		carry = (result[2 * i + 1] < high);
+	}
+}
+
+nrsa::limb_type nrsa::RSABigInt::add_limbs(limb_type* target, const limb_type* source, size_t count)
+{
+	limb_type carry{};
+	for (size_t i = 0; i < count; ++i)
+	{
+		limb_type sum = target[i] + source[i];
+		limb_type next_carry = sum < target[i];
+		target[i] = sum + carry;
+		carry = next_carry | (target[i] < sum);
+	}
+	return carry;
+}
+
+nrsa::limb_type nrsa::RSABigInt::subtract_limbs(limb_type* target, const limb_type* source, size_t count)
+{
+	limb_type borrow{};
+	for (size_t i = 0; i < count; ++i)
+	{
+		limb_type difference = target[i] - source[i];
+		limb_type next_borrow = target[i] < source[i];
+		target[i] = difference - borrow;
+		borrow = next_borrow | (difference < borrow);
+	}
+	return borrow;
+}
+
+nrsa::limb_type nrsa::RSABigInt::_add_carry(limb_type* target, size_t count, limb_type carry)
+{
+	for (size_t i = 0; carry and i < count; ++i)
+		carry = (++target[i] == 0);
+	return carry;
+}
+
+nrsa::limb_type nrsa::RSABigInt::_subtract_borrow(limb_type* target, size_t count, limb_type borrow)
+{
+	for (size_t i = 0; borrow and i < count; ++i)
+		borrow = (target[i]-- == 0);
+	return borrow;
+}
+
+void nrsa::RSABigInt::_normalize()
+{
+	while (not _limbs.empty() and _limbs.back() == 0)
+		_limbs.pop_back();
+}
+
+nrsa::RSABigInt nrsa::operator/(const RSABigInt& a, const RSABigInt& b)
+{
+	RSABigInt quotient, remainder;
+	RSABigInt::divide(a, b, quotient, remainder);
+	return quotient;
+}
+
+nrsa::RSABigInt nrsa::operator%(const RSABigInt& a, const RSABigInt& b)
+{
+	RSABigInt quotient, remainder;
+	RSABigInt::divide(a, b, quotient, remainder);
+	return remainder;
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace nrsa
+{
+	using limb_type = uint64_t;
+
+	// Products of more limbs than this are split by Karatsuba, smaller ones are computed directly
+	constexpr size_t RSA_KARATSUBA_THRESHOLD = 24;
+
+
+	// Unsigned integer of any size: 64 bits limbs from the least significant one, without leading zero limbs
+	class RSABigInt
+	{
+	public:
+		RSABigInt() = default;
+		RSABigInt(uint64_t value);
+
+		// Decimal digits only, false for anything else
+		static bool from_string(std::string_view decimal, RSABigInt& value);
+		std::string to_string() const;
+
+		// Decimal digits are written right into the end of the text
+		void append_to_string(std::string& text) const;
+
+		static RSABigInt from_limbs(const limb_type* limbs, size_t limbs_count);
+
+		// Big endian bytes, to_bytes pads them by zeros to the size and fails when the number is longer
+		static RSABigInt from_bytes(const char* bytes, size_t size);
+		bool to_bytes(char* bytes, size_t size) const;
+
+		// Limbs of 8 little endian bytes from the least significant one, padded by zero limbs the same way
+		static RSABigInt from_little_endian(const char* bytes, size_t limbs_count);
+		bool to_little_endian(char* bytes, size_t limbs_count) const;
+		const std::vector<limb_type>& limbs() const { return _limbs; }
+		size_t limbs_count() const { return _limbs.size(); }
+
+		bool is_zero() const { return _limbs.empty(); }
+		bool is_odd() const { return not _limbs.empty() and (_limbs[0] & 1); }
+		uint64_t low_limb() const { return _limbs.empty() ? 0 : _limbs[0]; }
+
+		size_t bits_count() const;
+		bool bit(size_t index) const;
+		void set_bit(size_t index);
+
+		int compare(const RSABigInt& other) const;
+
+		RSABigInt& operator+=(const RSABigInt& other);
+
+		// Other must not be greater
+		RSABigInt& operator-=(const RSABigInt& other);
+		RSABigInt& operator*=(const RSABigInt& other);
+		RSABigInt& operator<<=(size_t shift);
+		RSABigInt& operator>>=(size_t shift);
+
+		// Divisor must not be zero
+		static void divide(const RSABigInt& dividend, const RSABigInt& divisor, RSABigInt& quotient, RSABigInt& remainder);
+		uint64_t divide_small(uint64_t divisor);
+		uint64_t mod_small(uint64_t divisor) const;
+
+		// result[count * 2] = a[count] * b[count], scratch has at least multiply_scratch_size(count) limbs
+		static void multiply(const limb_type* a, const limb_type* b, size_t count, limb_type* result, limb_type* scratch);
+		static size_t multiply_scratch_size(size_t count);
+
+		// result[a_count + b_count] = a * b by rows
+		static void multiply_schoolbook(const limb_type* a, size_t a_count, const limb_type* b, size_t b_count, limb_type* result);
+
+		// Carry or borrow of the whole operation
+		static limb_type add_limbs(limb_type* target, const limb_type* source, size_t count);
+		static limb_type subtract_limbs(limb_type* target, const limb_type* source, size_t count);
+
+	private:
+		static void _square_schoolbook(const limb_type* a, size_t count, limb_type* result);
+
+		static limb_type _add_carry(limb_type* target, size_t count, limb_type carry);
+		static limb_type _subtract_borrow(limb_type* target, size_t count, limb_type borrow);
+
+		void _normalize();
+
+	private:
+		std::vector<limb_type> _limbs;
+	};
+
+
+	inline bool operator==(const RSABigInt& a, const RSABigInt& b) { return a.compare(b) == 0; }
+	inline bool operator!=(const RSABigInt& a, const RSABigInt& b) { return a.compare(b) != 0; }
+	inline bool operator<(const RSABigInt& a, const RSABigInt& b) { return a.compare(b) < 0; }
+	inline bool operator<=(const RSABigInt& a, const RSABigInt& b) { return a.compare(b) <= 0; }
+	inline bool operator>(const RSABigInt& a, const RSABigInt& b) { return a.compare(b) > 0; }
+	inline bool operator>=(const RSABigInt& a, const RSABigInt& b) { return a.compare(b) >= 0; }
+
+	inline RSABigInt operator+(RSABigInt a, const RSABigInt& b) { return a += b; }
+	inline RSABigInt operator-(RSABigInt a, const RSABigInt& b) { return a -= b; }
+	inline RSABigInt operator*(RSABigInt a, const RSABigInt& b) { return a *= b; }
+	inline RSABigInt operator<<(RSABigInt a, size_t shift) { return a <<= shift; }
+	inline RSABigInt operator>>(RSABigInt a, size_t shift) { return a >>= shift; }
+
+	RSABigInt operator/(const RSABigInt& a, const RSABigInt& b);
+	RSABigInt operator%(const RSABigInt& a, const RSABigInt& b);
+
+
+	// high:low = a * b, MSVC has no 128 bits integers, but its intrinsic gives the high limb on x64 and ARM64
+	inline limb_type multiply_wide(limb_type a, limb_type b, limb_type& high)
+	{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+		high = __umulh(a, b);
+		return a * b;
+#elif defined(_MSC_VER)
+		// Four products of the 32 bits halves, the middle sum never overflows
+		limb_type a_low = a & 0xFFFFFFFF, a_high = a >> 32;
+		limb_type b_low = b & 0xFFFFFFFF, b_high = b >> 32;
+
+		limb_type low_low = a_low * b_low;
+		limb_type high_low = a_high * b_low;
+		limb_type middle = (low_low >> 32) + (high_low & 0xFFFFFFFF) + a_low * b_high;
+
+		high = a_high * b_high + (high_low >> 32) + (middle >> 32);
+		return (middle << 32) | (low_low & 0xFFFFFFFF);
+#else
+		unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+		high = static_cast<limb_type>(product >> 64);
+		return static_cast<limb_type>(product);
+#endif
+	}
+
+	// high:low = a * b + c + d, never overflows
+	inline limb_type multiply_add(limb_type a, limb_type b, limb_type c, limb_type d, limb_type& high)
+	{
+#if defined(_MSC_VER)
+		limb_type low = multiply_wide(a, b, high);
+		low += c;
+		high += (low < c);
+		low += d;
+		high += (low < d);
+		return low;
+#else
+		unsigned __int128 product = static_cast<unsigned __int128>(a) * b + c + d;
+		high = static_cast<limb_type>(product >> 64);
+		return static_cast<limb_type>(product);
+#endif
+	}
+
+	// high:low / divisor, high must be less than the divisor, so the quotient is one limb
+	inline limb_type divide_wide(limb_type high, limb_type low, limb_type divisor, limb_type& remainder)
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		return _udiv128(high, low, divisor, &remainder);
+#elif defined(_MSC_VER)
+		// Bit by bit, the rest stays less than the divisor
+		limb_type quotient{};
+		for (int16_t i = 0; i < 64; ++i)
+		{
+			bool is_carry = (high >> 63) != 0;
+			high = (high << 1) | (low >> 63);
+			low <<= 1;
+			quotient <<= 1;
+
+			if (is_carry or high >= divisor)
+			{
+				high -= divisor;
+				quotient |= 1;
+			}
+		}
+		remainder = high;
+		return quotient;
+#else
+		unsigned __int128 numerator = (static_cast<unsigned __int128>(high) << 64) | low;
+		remainder = static_cast<limb_type>(numerator % divisor);
+		return static_cast<limb_type>(numerator / divisor);
+#endif
+	}
+}
@@ -0,0 +1,149 @@
+#include "RSADecimal.hpp"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define RSA_DECIMAL_SSE2
+#endif
+
+namespace
+{
+	constexpr char DIGIT_PAIRS[] =
+		"00010203040506070809"
+		"10111213141516171819"
+		"20212223242526272829"
+		"30313233343536373839"
+		"40414243444546474849"
+		"50515253545556575859"
+		"60616263646566676869"
+		"70717273747576777879"
+		"80818283848586878889"
+		"90919293949596979899";
+
+	bool is_space(char symbol)
+	{
+		return symbol == ' ' or (symbol >= '\t' and symbol <= '\r');
+	}
+
+	bool is_digit(char symbol)
+	{
+		return symbol >= '0' and symbol <= '9';
+	}
+
+	// First digit is in the lowest byte: pairs, then fours, then the whole 8 digits by the multiplications of the lanes
+	uint64_t parse_eight_digits(const char* digits)
+	{
+		uint64_t value{};
+		for (size_t i = 0; i < 8; ++i)
+			value |= static_cast<uint64_t>(static_cast<uint8_t>(digits[i])) << (8 * i);
+
+		value -= 0x3030303030303030ull;
+		value = (value * 10 + (value >> 8)) & 0x00FF00FF00FF00FFull;
+		value = (value * 100 + (value >> 16)) & 0x0000FFFF0000FFFFull;
+		return (value * 10000 + (value >> 32)) & 0xFFFFFFFFull;
+	}
+
+#if defined(RSA_DECIMAL_SSE2)
+	// Bit of every byte of 16, which is whitespace or digit
+	uint32_t get_spaces_mask(const char* data)
+	{
+		__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+		__m128i is_blank = _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' '));
+		__m128i is_control = _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8('\t' - 1)), _mm_cmplt_epi8(bytes, _mm_set1_epi8('\r' + 1)));
+		return static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(is_blank, is_control)));
+	}
+
+	uint32_t get_digits_mask(const char* data)
+	{
+		__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+		__m128i is_digit = _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(bytes, _mm_set1_epi8('9' + 1)));
+		return static_cast<uint32_t>(_mm_movemask_epi8(is_digit));
+	}
+#endif
+}
+
+uint64_t nrsa::parse_decimal(const char* digits, size_t count)
+{
+	uint64_t value{};
+	for (; count >= 8; digits += 8, count -= 8)
+		value = value * 100000000 + parse_eight_digits(digits);
+
+	for (; count > 0; ++digits, --count)
+		value = value * 10 + static_cast<uint64_t>(*digits - '0');
+	return value;
+}
+
+char* nrsa::format_decimal(uint64_t value, char* end, size_t min_count)
+{
+	char* begin = end;
+	while (value >= 100)
+	{
+		begin -= 2;
+		std::memcpy(begin, DIGIT_PAIRS + 2 * (value % 100), 2);
+		value /= 100;
+	}
+
+	if (value >= 10)
+	{
+		begin -= 2;
+		std::memcpy(begin, DIGIT_PAIRS + 2 * value, 2);
+	}
+	else
+		*--begin = static_cast<char>('0' + value);
+
+	while (static_cast<size_t>(end - begin) < min_count)
+		*--begin = '0';
+	return begin;
+}
+
+bool nrsa::RSADecimalScanner::next(std::string_view& token)
+{
+	size_t begin = _skip_spaces(_position);
+	if (begin == _size)
+	{
+		_position = _size;
+		return false;
+	}
+
+	// Token with other symbols goes up to the whitespace
+	size_t end = _skip_digits(begin);
+	while (end < _size and not is_space(_data[end]))
+		++end;
+
+	_position = end;
+	token = std::string_view(_data + begin, end - begin);
+	return true;
+}
+
+size_t nrsa::RSADecimalScanner::_skip_spaces(size_t position) const
+{
+#if defined(RSA_DECIMAL_SSE2)
+	for (; position + 16 <= _size; position += 16)
+	{
+		uint32_t mask = get_spaces_mask(_data + position) ^ 0xFFFF;
+		if (mask)
+			return position + static_cast<size_t>(__builtin_ctz(mask));
+	}
+#endif
+
+	while (position < _size and is_space(_data[position]))
+		++position;
+	return position;
+}
+
+size_t nrsa::RSADecimalScanner::_skip_digits(size_t position) const
+{
+#if defined(RSA_DECIMAL_SSE2)
+	for (; position + 16 <= _size; position += 16)
+	{
+		uint32_t mask = get_digits_mask(_data + position) ^ 0xFFFF;
+		if (mask)
+			return position + static_cast<size_t>(__builtin_ctz(mask));
+	}
+#endif
+
+	while (position < _size and is_digit(_data[position]))
+		++position;
+	return position;
+}
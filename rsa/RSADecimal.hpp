@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include <string_view>
+
+namespace nrsa
+{
+	// Digits of uint64_t, the largest power of ten in it has 19 of them
+	constexpr size_t RSA_DECIMAL_LIMB_DIGITS = 19;
+	constexpr size_t RSA_DECIMAL_MAX_DIGITS = 20;
+
+
+	// Value of at most 19 digits, which are checked before, 8 digits go at once in one register
+	uint64_t parse_decimal(const char* digits, size_t count);
+
+	// Digits of the value are written to end at the end, by two at once, padded by zeros to min_count.
+	// Returns the first digit
+	char* format_decimal(uint64_t value, char* end, size_t min_count = 1);
+
+
+	// Tokens of the text data separated by the whitespace, scanned by 16 bytes at once with SSE2.
+	// Numbers are runs of decimal digits, the tokens with other symbols are returned too, so the parsing rejects them
+	class RSADecimalScanner
+	{
+	public:
+		RSADecimalScanner(const char* data, size_t size) : _data(data), _size(size) {}
+
+		// Token points into the data, false at the end
+		bool next(std::string_view& token);
+
+	private:
+		size_t _skip_spaces(size_t position) const;
+		size_t _skip_digits(size_t position) const;
+
+	private:
+		const char* _data;
+		size_t _size;
+		size_t _position{};
+	};
+}
@@ -0,0 +1,194 @@
+#include "RSAMontgomery.hpp"
+
+#include <algorithm>
+
+namespace
+{
+	// Newton iterations double the correct low bits of the inverse, an odd number is its own inverse by 3 bits
+	uint64_t get_inverse(uint64_t val)
+	{
+		uint64_t inverse = val;
+		for (int16_t i = 0; i < 5; ++i)
+			inverse *= 2 - val * inverse;
+		return inverse;
+	}
+}
+
+nrsa::RSAMontgomery64::RSAMontgomery64(uint64_t modulus) : _modulus(modulus), _inverse(get_inverse(modulus))
+{
+	// R mod modulus = (2^64 - modulus) mod modulus
+	uint64_t r = (0 - modulus) % modulus;
+	uint64_t high{};
+	uint64_t low = multiply_wide(r, r, high);
+	divide_wide(high, low, modulus, _r2);
+}
+
+uint64_t nrsa::RSAMontgomery64::pow_mod(uint64_t base, uint64_t exponent) const
+{
+	uint64_t result = to_form(1);
+	base = to_form(base);
+
+	while (exponent)
+	{
+		if (exponent & 1)
+			result = multiply(result, base);
+		base = multiply(base, base);
+		exponent >>= 1;
+	}
+	return from_form(result);
+}
+
+nrsa::RSAMontgomery::RSAMontgomery(const RSABigInt& modulus)
+	: _modulus(modulus), _count(modulus.limbs_count()), _modulus_limbs(modulus.limbs())
+{
+	_modulus_inverse = 0 - get_inverse(_modulus_limbs[0]);
+
+	if (_count == 1)
+		_montgomery64 = RSAMontgomery64(_modulus_limbs[0]);
+
+	RSABigInt r2 = (RSABigInt(1) << (128 * _count)) % _modulus;
+	_r2 = r2.limbs();
+	_r2.resize(_count, 0);
+}
+
+nrsa::RSAMontgomery::RSAMontgomery(const RSABigInt& modulus, limb_type modulus_inverse, const RSABigInt& r2)
+	: _modulus(modulus), _count(modulus.limbs_count()), _modulus_limbs(modulus.limbs()), _modulus_inverse(modulus_inverse), _r2(r2.limbs())
+{
+	_r2.resize(_count, 0);
+
+	if (_count == 1)
+		_montgomery64 = RSAMontgomery64(_modulus_limbs[0]);
+}
+
+nrsa::RSABigInt nrsa::RSAMontgomery::pow_mod(const RSABigInt& base, const RSABigInt& exponent) const
+{
+	if (_count == 1 and exponent.limbs_count() <= 1)
+		return _montgomery64.pow_mod(base.mod_small(_modulus_limbs[0]), exponent.low_limb());
+
+	size_t exponent_bits = exponent.bits_count();
+	size_t window_bits = (exponent_bits > RSA_WIDE_WINDOW_BITS) ? 5 : 4;
+	size_t table_size = size_t{ 1 } << (window_bits - 1);
+
+	// Odd powers of the base, accumulator, one and the square of the base, then the product and Karatsuba
+	std::vector<limb_type> memory((table_size + 3) * _count + 2 * _count + 1 + RSABigInt::multiply_scratch_size(_count));
+	limb_type* table = memory.data();
+	limb_type* accumulator = table + table_size * _count;
+	limb_type* one = accumulator + _count;
+	limb_type* square = one + _count;
+	limb_type* product = square + _count;
+	limb_type* scratch = product + 2 * _count + 1;
+
+	RSABigInt reduced_base = (base < _modulus) ? base : base % _modulus;
+	std::copy(reduced_base.limbs().begin(), reduced_base.limbs().end(), accumulator);
+	one[0] = 1;
+
+	// To the Montgomery form by the multiplication with R^2
+	_multiply(accumulator, _r2.data(), table, product, scratch);
+	_multiply(table, table, square, product, scratch);
+	for (size_t i = 1; i < table_size; ++i)
+		_multiply(table + (i - 1) * _count, square, table + i * _count, product, scratch);
+
+	// x^0 = 1, it is R mod modulus in the Montgomery form
+	_multiply(one, _r2.data(), accumulator, product, scratch);
+
+	// Sliding windows from the top bit, every window starts and ends by the set bit
+	bool is_started = false;
+	for (size_t i = exponent_bits; i-- > 0;)
+	{
+		if (not exponent.bit(i))
+		{
+			if (is_started)
+				_multiply(accumulator, accumulator, accumulator, product, scratch);
+			continue;
+		}
+
+		size_t low = (i + 1 >= window_bits) ? i + 1 - window_bits : 0;
+		while (not exponent.bit(low))
+			++low;
+
+		size_t window{};
+		for (size_t j = i + 1; j-- > low;)
+		{
+			window = (window << 1) | exponent.bit(j);
+			if (is_started)
+				_multiply(accumulator, accumulator, accumulator, product, scratch);
+		}
+
+		if (is_started)
+			_multiply(accumulator, table + (window >> 1) * _count, accumulator, product, scratch);
+		else
+			std::copy(table + (window >> 1) * _count, table + (window >> 1) * _count + _count, accumulator);
+
+		is_started = true;
+		i = low;
+	}
+
+	// From the Montgomery form by the multiplication with 1
+	_multiply(accumulator, one, accumulator, product, scratch);
+	return RSABigInt::from_limbs(accumulator, _count);
+}
+
+nrsa::RSABigInt nrsa::RSAMontgomery::to_form(const RSABigInt& val) const
+{
+	return multiply((val < _modulus) ? val : val % _modulus, r2());
+}
+
+nrsa::RSABigInt nrsa::RSAMontgomery::multiply(const RSABigInt& a, const RSABigInt& b) const
+{
+	// Both factors padded to count, then the product and Karatsuba
+	std::vector<limb_type> memory(2 * _count + 2 * _count + 1 + RSABigInt::multiply_scratch_size(_count));
+	limb_type* a_limbs = memory.data();
+	limb_type* b_limbs = a_limbs + _count;
+	limb_type* product = b_limbs + _count;
+	limb_type* scratch = product + 2 * _count + 1;
+
+	std::copy(a.limbs().begin(), a.limbs().end(), a_limbs);
+	std::copy(b.limbs().begin(), b.limbs().end(), b_limbs);
+
+	_multiply(a_limbs, b_limbs, a_limbs, product, scratch);
+	return RSABigInt::from_limbs(a_limbs, _count);
+}
+
+void nrsa::RSAMontgomery::_multiply(const limb_type* a, const limb_type* b, limb_type* result, limb_type* product, limb_type* scratch) const
+{
+	RSABigInt::multiply(a, b, _count, product, scratch);
+	product[2 * _count] = 0;
+	_reduce(product, result);
+}
+
+void nrsa::RSAMontgomery::_reduce(limb_type* product, limb_type* result) const
+{
+	const limb_type* modulus = _modulus_limbs.data();
+
+	// Every step makes the lowest limb zero by adding a multiple of the modulus
+	for (size_t i = 0; i < _count; ++i)
+	{
+		limb_type factor = product[i] * _modulus_inverse, carry{};
+		for (size_t j = 0; j < _count; ++j)
+			product[i + j] = multiply_add(factor, modulus[j], product[i + j], carry, carry);
+
+		for (size_t j = i + _count; carry and j <= 2 * _count; ++j)
+		{
+			product[j] += carry;
+			carry = (product[j] < carry);
+		}
+	}
+
+	// Result is less than 2 * modulus
+	limb_type* high = product + _count;
+	bool is_greater = high[_count] != 0;
+	if (not is_greater)
+	{
+		is_greater = true;
+		for (size_t i = _count; i-- > 0;)
+			if (high[i] != modulus[i])
+			{
+				is_greater = high[i] > modulus[i];
+				break;
+			}
+	}
+
+	if (is_greater)
+		RSABigInt::subtract_limbs(high, modulus, _count);
+	std::copy(high, high + _count, result);
+}
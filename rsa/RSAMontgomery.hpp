@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include <memory>
+#include <vector>
+
+#include "RSABigInt.hpp"
+
+namespace nrsa
+{
+	// Exponents longer than this use the windows of 5 bits, shorter ones the windows of 4 bits
+	constexpr size_t RSA_WIDE_WINDOW_BITS = 512;
+
+
+	// Montgomery form by an odd modulus of one limb, R = 2^64, every product is one 128 bits multiplication and a reduction
+	class RSAMontgomery64
+	{
+	public:
+		RSAMontgomery64() = default;
+
+		// Modulus must be odd
+		explicit RSAMontgomery64(uint64_t modulus);
+
+		uint64_t modulus() const { return _modulus; }
+
+		uint64_t to_form(uint64_t val) const { return multiply(val % _modulus, _r2); }
+		uint64_t from_form(uint64_t val) const { return _reduce(val, 0); }
+
+		// a * b / R mod modulus
+		uint64_t multiply(uint64_t a, uint64_t b) const
+		{
+			uint64_t high{};
+			uint64_t low = multiply_wide(a, b, high);
+			return _reduce(low, high);
+		}
+
+		uint64_t pow_mod(uint64_t base, uint64_t exponent) const;
+
+	private:
+		// high:low / R mod modulus, the subtraction of the multiple of the modulus instead of the addition
+		// does not overflow with the modulus above 2^63, the low limbs of both are the same
+		uint64_t _reduce(uint64_t low, uint64_t high) const
+		{
+			uint64_t factor = low * _inverse;
+			uint64_t multiple{};
+			multiply_wide(factor, _modulus, multiple);
+
+			return (high < multiple) ? high - multiple + _modulus : high - multiple;
+		}
+
+	private:
+		uint64_t _modulus{};
+
+		// modulus^-1 mod 2^64 and R^2 mod modulus
+		uint64_t _inverse{};
+		uint64_t _r2{};
+	};
+
+
+	// Montgomery form of the numbers by an odd modulus, R = 2^(64 * limbs of the modulus),
+	// it does not change after the creation, so one context can be used by many threads
+	class RSAMontgomery
+	{
+	public:
+		// Modulus must be odd and greater than 1
+		explicit RSAMontgomery(const RSABigInt& modulus);
+
+		// Constants saved before, without the division for R^2
+		RSAMontgomery(const RSABigInt& modulus, limb_type modulus_inverse, const RSABigInt& r2);
+
+		const RSABigInt& modulus() const { return _modulus; }
+
+		// -modulus^-1 mod 2^64 and R^2 mod modulus
+		limb_type modulus_inverse() const { return _modulus_inverse; }
+		RSABigInt r2() const { return RSABigInt::from_limbs(_r2.data(), _r2.size()); }
+
+		// base^exponent mod modulus, all the memory of the exponentiation is allocated once before it,
+		// one limb of the modulus and exponent goes by the 64 bits form without any memory
+		RSABigInt pow_mod(const RSABigInt& base, const RSABigInt& exponent) const;
+
+		// Montgomery form of val and back, and a * b / R mod modulus of two numbers of this form, they are less than the modulus
+		RSABigInt to_form(const RSABigInt& val) const;
+		RSABigInt from_form(const RSABigInt& val) const { return multiply(val, 1); }
+		RSABigInt multiply(const RSABigInt& a, const RSABigInt& b) const;
+
+	private:
+		// result = a * b / R mod modulus, product has 2 * count + 1 limbs, the rest of scratch goes to Karatsuba
+		void _multiply(const limb_type* a, const limb_type* b, limb_type* result, limb_type* product, limb_type* scratch) const;
+
+		// result = product / R mod modulus, product is destroyed
+		void _reduce(limb_type* product, limb_type* result) const;
+
+	private:
+		RSABigInt _modulus;
+		size_t _count{};
+
+		// Modulus limbs padded to count, -modulus^-1 mod 2^64 and R^2 mod modulus padded to count
+		std::vector<limb_type> _modulus_limbs;
+		limb_type _modulus_inverse{};
+		std::vector<limb_type> _r2;
+
+		// Used for the modulus of one limb
+		RSAMontgomery64 _montgomery64;
+	};
+
+	using rsa_montgomery_ptr = std::shared_ptr<const RSAMontgomery>;
+}
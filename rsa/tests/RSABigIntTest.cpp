@@ -0,0 +1,155 @@
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../RSABigInt.hpp"
+#include "../RSADecimal.hpp"
+#include "../RSAMontgomery.hpp"
+
+// Arithmetic of the big integers against known values, and the decimal parsing at the limits of one limb.
+// Built with RSABigInt.cpp, RSADecimal.cpp and RSAMontgomery.cpp
+namespace
+{
+	// RSA-100 and its factors
+	const char* const RSA100 = "1522605027922533360535618378132637429718068114961380688657908494580122963258952897654000350692006139";
+	const char* const RSA100_P = "37975227936943673922808872755445627854565536638199";
+	const char* const RSA100_Q = "40094690950920881030683735292761468389214899724061";
+
+	nrsa::RSABigInt number(const char* decimal)
+	{
+		nrsa::RSABigInt value;
+		nrsa::RSABigInt::from_string(decimal, value);
+		return value;
+	}
+
+	// 2^bits - 1
+	nrsa::RSABigInt all_ones(size_t bits)
+	{
+		return (nrsa::RSABigInt(1) << bits) - 1;
+	}
+
+	int check(const std::string& name, bool is_passed)
+	{
+		std::cout << (is_passed ? "[PASSED] " : "[FAILED] ") << name << std::endl;
+		return is_passed ? 0 : 1;
+	}
+
+	int test_multiply()
+	{
+		nrsa::RSABigInt p = number(RSA100_P), q = number(RSA100_Q);
+		int failures = check("multiply: RSA-100", (p * q).to_string() == RSA100);
+
+		nrsa::limb_type high{};
+		nrsa::limb_type low = nrsa::multiply_wide(UINT64_MAX, UINT64_MAX, high);
+		failures += check("multiply: two limbs of 2^64 - 1", low == 1 and high == UINT64_MAX - 1);
+
+		// (2^n - 1)^2 = 2^2n - 2^(n + 1) + 1, the long ones go through Karatsuba
+		for (size_t bits : { 63, 64, 65, 1000, 4096, 10007 })
+		{
+			nrsa::RSABigInt expected = (nrsa::RSABigInt(1) << (2 * bits)) - (nrsa::RSABigInt(1) << (bits + 1)) + 1;
+			failures += check("multiply: (2^" + std::to_string(bits) + " - 1)^2", all_ones(bits) * all_ones(bits) == expected);
+		}
+
+		// Karatsuba against the rows for the same limbs
+		const size_t count = 4 * nrsa::RSA_KARATSUBA_THRESHOLD + 3;
+		std::vector<nrsa::limb_type> a(count), b(count), result(2 * count), rows(2 * count);
+		std::vector<nrsa::limb_type> scratch(nrsa::RSABigInt::multiply_scratch_size(count));
+		for (size_t i = 0; i < count; ++i)
+		{
+			a[i] = UINT64_MAX - i * 0x9E3779B97F4A7C15;
+			b[i] = (i % 3 == 0) ? UINT64_MAX : i * 0xC2B2AE3D27D4EB4F;
+		}
+
+		nrsa::RSABigInt::multiply(a.data(), b.data(), count, result.data(), scratch.data());
+		nrsa::RSABigInt::multiply_schoolbook(a.data(), count, b.data(), count, rows.data());
+		failures += check("multiply: Karatsuba equals the rows", result == rows);
+		return failures;
+	}
+
+	int test_divide()
+	{
+		nrsa::RSABigInt n = number(RSA100), p = number(RSA100_P), q = number(RSA100_Q);
+		int failures = check("divide: RSA-100 by p", n / p == q and (n % p).is_zero());
+
+		// n^2 + 12345 by p
+		nrsa::RSABigInt quotient, remainder;
+		nrsa::RSABigInt::divide(n * n + 12345, p, quotient, remainder);
+		failures += check("divide: with remainder", quotient.to_string() == "61048378034872233719178085414154434555358240536694299462869842471173415702679772925766952874121970788530419312460416534955475587458949420669618010479"
+			and remainder == 12345);
+
+		// Divisors of one limb and with the top limb at its maximum, where the estimate of the quotient digit is corrected
+		for (size_t bits : { 64, 127, 128, 521, 2048 })
+		{
+			nrsa::RSABigInt dividend = all_ones(3 * bits + 17) - 5;
+			nrsa::RSABigInt divisor = all_ones(bits);
+			nrsa::RSABigInt::divide(dividend, divisor, quotient, remainder);
+			failures += check("divide: by 2^" + std::to_string(bits) + " - 1", quotient * divisor + remainder == dividend and remainder < divisor);
+		}
+		return failures;
+	}
+
+	int test_pow_mod()
+	{
+		nrsa::RSABigInt n = number(RSA100), p = number(RSA100_P), q = number(RSA100_Q);
+
+		nrsa::RSAMontgomery q_context(q);
+		int failures = check("pow_mod: p^65537 mod q", q_context.pow_mod(p, 65537).to_string() == "35542028364383659892790501901662790164594934144169");
+
+		// Exponent of more than 512 bits, with the wide windows
+		nrsa::RSAMontgomery n_context(n);
+		nrsa::RSABigInt exponent = (nrsa::RSABigInt(1) << 600) + 1;
+		failures += check("pow_mod: long exponent", n_context.pow_mod(123456789, exponent).to_string() == "1153434717529222100052624349795672684207100139877570896991537912968184659293923943364553736242056270");
+
+		nrsa::RSAMontgomery mersenne_context(all_ones(127));
+		failures += check("pow_mod: 2^RSA-100 mod 2^127 - 1", mersenne_context.pow_mod(2, n).to_string() == "1125899906842624");
+
+		// Fermat for the prime 2^521 - 1
+		nrsa::RSAMontgomery prime_context(all_ones(521));
+		failures += check("pow_mod: Fermat for 2^521 - 1", prime_context.pow_mod(n, all_ones(521) - 1) == 1);
+
+		// One limb goes by the 64 bits form
+		nrsa::RSAMontgomery64 small_context(UINT64_MAX - 58);
+		failures += check("pow_mod: Fermat for 2^64 - 59", small_context.pow_mod(3, UINT64_MAX - 59) == 1);
+		return failures;
+	}
+
+	int test_decimal()
+	{
+		int failures = check("decimal: 19 digits", nrsa::parse_decimal("9999999999999999999", 19) == 9999999999999999999ull
+			and nrsa::parse_decimal("1234567890123456789", 19) == 1234567890123456789ull);
+
+		// 20 digits are more than one chunk of the parser
+		nrsa::RSABigInt value;
+		failures += check("decimal: 2^64 - 1", nrsa::RSABigInt::from_string("18446744073709551615", value) and value == UINT64_MAX and value.limbs_count() == 1);
+		failures += check("decimal: 2^64", nrsa::RSABigInt::from_string("18446744073709551616", value) and value == nrsa::RSABigInt(1) << 64);
+		failures += check("decimal: round trip", number(RSA100).to_string() == RSA100 and number("10000000000000000000").to_string() == "10000000000000000000");
+		failures += check("decimal: not a number", not nrsa::RSABigInt::from_string("12a", value) and not nrsa::RSABigInt::from_string("", value));
+
+		char digits[nrsa::RSA_DECIMAL_MAX_DIGITS];
+		char* end = digits + nrsa::RSA_DECIMAL_MAX_DIGITS;
+		failures += check("decimal: format 20 digits", std::string(nrsa::format_decimal(UINT64_MAX, end), end) == "18446744073709551615");
+
+		// Tokens across the 16 bytes blocks of the scanner, the one with a letter is returned too
+		std::string text = " 9999999999999999999\n18446744073709551616  12x4\t\t0 ";
+		nrsa::RSADecimalScanner scanner(text.data(), text.size());
+
+		std::vector<std::string> tokens;
+		for (std::string_view token; scanner.next(token);)
+			tokens.emplace_back(token);
+		failures += check("decimal: scanner", tokens == std::vector<std::string>{ "9999999999999999999", "18446744073709551616", "12x4", "0" });
+		return failures;
+	}
+}
+
+int main()
+{
+	int failures = test_multiply();
+	failures += test_divide();
+	failures += test_pow_mod();
+	failures += test_decimal();
+
+	std::cout << (failures ? "Some tests failed!" : "All tests passed.") << std::endl;
+	return failures ? 1 : 0;
+}
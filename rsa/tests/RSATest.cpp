@@ -0,0 +1,176 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "../RSA.hpp"
+
+// Keys and data of the RSA files: decoding with and without the factors, forged padding and binary keys.
+// Built with the RSA sources except main.cpp, runs in a directory where it may write its files
+namespace
+{
+	const char* const SOURCE_FILENAME = "rsa_source.txt";
+	const char* const FORGED_FILENAME = "rsa_forged.txt";
+
+	const char* const KEY_NAME = "rsa_test_key";
+	const char* const PUBLIC_KEY_FILENAME = "rsa_test_key_pub.txt";
+	const char* const PRIVATE_KEY_FILENAME = "rsa_test_key.txt";
+	const char* const PUBLIC_BINARY_KEY_FILENAME = "rsa_test_key_pub.bin";
+	const char* const PRIVATE_BINARY_KEY_FILENAME = "rsa_test_key.bin";
+	const char* const PLAIN_KEY_FILENAME = "rsa_test_plain_key.txt";
+
+	const char* const SOURCE = "Known text of the tests, long enough for a few blocks of a 512 bits modulus. 0123456789";
+
+	std::string read_file(const char* filename)
+	{
+		std::ifstream fin(filename, std::ios::binary);
+		std::stringstream ss;
+		ss << fin.rdbuf();
+		return ss.str();
+	}
+
+	void write_file(const char* filename, const std::string& data)
+	{
+		std::ofstream fout(filename, std::ios::binary);
+		fout.write(data.data(), data.size());
+	}
+
+	// Decoded data of the encoded file with the given keys, empty when the keys or the data are rejected
+	std::string decode_with(const char* public_filename, const char* private_filename, const char* encoded_filename = nullptr)
+	{
+		std::remove(nrsa::RSA_DECODED_DATA_FILENAME);
+
+		nrsa::RSA rsa;
+		if (not rsa.load_keys(public_filename, private_filename) or not rsa.decode(encoded_filename))
+			return {};
+		return read_file(nrsa::RSA_DECODED_DATA_FILENAME);
+	}
+
+	int check(const char* name, bool is_passed)
+	{
+		std::cout << (is_passed ? "[PASSED] " : "[FAILED] ") << name << std::endl;
+		return is_passed ? 0 : 1;
+	}
+
+	// Text private key has p, q, dP, dQ and qInv after d and n, the key without them decodes by one exponentiation
+	int test_crt()
+	{
+		nrsa::RSA rsa(12345);
+		rsa.set_key_size(512);
+		rsa.generate_keys();
+		rsa.save_keys(KEY_NAME);
+
+		if (not rsa.encode(SOURCE_FILENAME))
+			return check("CRT: encode", false);
+
+		int failures = check("CRT: decoded with the factors", decode_with(PUBLIC_KEY_FILENAME, PRIVATE_KEY_FILENAME) == SOURCE);
+
+		std::istringstream key(read_file(PRIVATE_KEY_FILENAME));
+		std::string exp, modulus, p, q, exp_p, exp_q, q_inverse;
+		key >> exp >> modulus >> p >> q >> exp_p >> exp_q >> q_inverse;
+
+		write_file(PLAIN_KEY_FILENAME, exp + " " + modulus);
+		failures += check("CRT: decoded without the factors", decode_with(PUBLIC_KEY_FILENAME, PLAIN_KEY_FILENAME) == SOURCE);
+
+		// dP of another key does not agree with d
+		write_file(PLAIN_KEY_FILENAME, exp + " " + modulus + " " + p + " " + q + " " + exp_q + " " + exp_q + " " + q_inverse);
+		failures += check("CRT: wrong factors rejected", decode_with(PUBLIC_KEY_FILENAME, PLAIN_KEY_FILENAME).empty());
+		return failures;
+	}
+
+	// Value which the public key makes from the block, as the encoder would do it with any padding
+	std::string encode_block(const std::string& block)
+	{
+		std::istringstream key(read_file(PUBLIC_KEY_FILENAME));
+		std::string exp_text, modulus_text;
+		key >> exp_text >> modulus_text;
+
+		nrsa::RSABigInt exp, modulus;
+		nrsa::RSABigInt::from_string(exp_text, exp);
+		nrsa::RSABigInt::from_string(modulus_text, modulus);
+
+		nrsa::RSAMontgomery context(modulus);
+		return context.pow_mod(nrsa::RSABigInt::from_bytes(block.data(), block.size()), exp).to_string() + " ";
+	}
+
+	int test_padding()
+	{
+		// 00 02, nonzero random bytes, 00 and the data in the 64 bytes of the modulus
+		std::string block(64, '\x5A');
+		block[0] = 0;
+		block[1] = 2;
+		block[20] = 0;
+
+		write_file(FORGED_FILENAME, encode_block(block));
+		int failures = check("padding: valid block decoded", decode_with(PUBLIC_KEY_FILENAME, PRIVATE_KEY_FILENAME, FORGED_FILENAME) == block.substr(21));
+
+		std::string forged = block;
+		forged[1] = 1;
+		write_file(FORGED_FILENAME, encode_block(forged));
+		failures += check("padding: wrong block type rejected", decode_with(PUBLIC_KEY_FILENAME, PRIVATE_KEY_FILENAME, FORGED_FILENAME).empty());
+
+		// Less than 8 random bytes before the separator
+		forged = block;
+		forged[6] = 0;
+		write_file(FORGED_FILENAME, encode_block(forged));
+		failures += check("padding: short random part rejected", decode_with(PUBLIC_KEY_FILENAME, PRIVATE_KEY_FILENAME, FORGED_FILENAME).empty());
+
+		forged = block;
+		forged[20] = '\x5A';
+		write_file(FORGED_FILENAME, encode_block(forged));
+		failures += check("padding: no separator rejected", decode_with(PUBLIC_KEY_FILENAME, PRIVATE_KEY_FILENAME, FORGED_FILENAME).empty());
+		return failures;
+	}
+
+	// Position of the low limb of R^2 of the modulus in a binary private key with the factors
+	size_t r2_position(const std::string& key_data)
+	{
+		auto limbs_count = [&key_data](size_t position)
+			{
+				return static_cast<size_t>(static_cast<uint8_t>(key_data[position])) | static_cast<size_t>(static_cast<uint8_t>(key_data[position + 1])) << 8;
+			};
+
+		// e or d, n, 5 numbers of the factors and -n^-1, then R^2
+		size_t position = nrsa::RSA_BINARY_HEADER_SIZE;
+		for (int16_t i = 0; i < 8; ++i)
+			position += 4 + 8 * limbs_count(position);
+		return position + 4;
+	}
+
+	int test_binary_key()
+	{
+		nrsa::RSA rsa(54321);
+		rsa.set_key_size(512);
+		rsa.set_binary(true);
+		rsa.generate_keys();
+		rsa.save_keys(KEY_NAME);
+
+		if (not rsa.encode(SOURCE_FILENAME))
+			return check("binary key: encode", false);
+
+		int failures = check("binary key: round trip", decode_with(PUBLIC_BINARY_KEY_FILENAME, PRIVATE_BINARY_KEY_FILENAME, nrsa::RSA_ENCODED_BINARY_FILENAME) == SOURCE);
+
+		std::string key_data = read_file(PRIVATE_BINARY_KEY_FILENAME);
+		failures += check("binary key: has the Montgomery constants", key_data.size() > 4 and (key_data[4] & nrsa::RSA_KEY_FLAG_MONTGOMERY) != 0);
+
+		// R^2 is still less than the modulus, but it is not the right one
+		key_data[r2_position(key_data)] ^= 1;
+		write_file(PRIVATE_BINARY_KEY_FILENAME, key_data);
+		failures += check("binary key: wrong R^2 rejected", decode_with(PUBLIC_BINARY_KEY_FILENAME, PRIVATE_BINARY_KEY_FILENAME, nrsa::RSA_ENCODED_BINARY_FILENAME).empty());
+		return failures;
+	}
+}
+
+int main()
+{
+	write_file(SOURCE_FILENAME, SOURCE);
+
+	int failures = test_crt();
+	failures += test_padding();
+	failures += test_binary_key();
+
+	std::cout << (failures ? "Some tests failed!" : "All tests passed.") << std::endl;
+	return failures ? 1 : 0;
+}